@@ -12,11 +12,22 @@
 #define ITERATION_LENGTH_MAX 3.0f
 #define ITERATION_LENGTH_MIN 0.001f
 #define ITERATION_LENGTH_STRENGTH 3.0f
+#define HEADLESS_READ_MAX (1ULL << 32) // cells, the largest board read back into one byte per cell
+
+// build with -DCPU_ONLY for the machines without OpenGL and OpenCL: only the CPU engines are compiled in, for the headless, the ensemble, the benchmark and the distributed modes
 
 
 #include <iostream>
 #include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <memory>
 
+#ifndef CPU_ONLY
 // include the OpenGL libraries
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -32,17 +43,44 @@
 #include "kernel.h"
 #include "screen.h"
 #include "camera.h"
+#include "kernel_ensemble.h"
+#include "kernel_multi.h"
+#include "simulation.h"
+#endif
+
+#include "engines.h"
+#include "ensemble.h"
+#include "image.h"
+#include "benchmark.h"
+#include "metrics.h"
+#include "distributed.h"
+#include "checkpoint.h"
+#include "pattern.h"
+#include "exporter.h"
 
 
 // function declarations
-GLFWwindow* initialiseOpenGL();
+#ifndef CPU_ONLY
+GLFWwindow* initialiseOpenGL(bool = true);
 void framebufferSizeCallback(GLFWwindow*, int, int);
 void mouseCallback(GLFWwindow*, double, double);
 void mouseButtonCallback(GLFWwindow*, int, int, int);
 void scrollCallback(GLFWwindow*, double, double);
 void processInput(GLFWwindow*);
+void toggleRecording();
+void takeCheckpoint();
 void countFPS(float);
+int runWindow(int, const char*[]);
+#endif
+int runHeadless(int, const char*[]);
+int runEnsemble(int, const char*[]);
+int runBenchmarkMode(int, const char*[]);
+int runDistributedMode(int, const char*[]);
+std::vector<std::string> splitList(const std::string&);
+std::string setEngineRule(Engine*, const Rule&, const std::string&, const std::string&);
+void runScaling(const std::string&, const Rule&, const std::string&, const std::string&, const std::vector<unsigned char>&, int, int, unsigned int, unsigned int);
 
+#ifndef CPU_ONLY
 #ifdef RETINA
 // dimensions of the viewport (they have to be multiplied by 2 at the retina displays)
 unsigned int scr_width = SCR_WIDTH*2;
@@ -55,10 +93,11 @@ unsigned int scr_height = SCR_HEIGHT;
 // variables used in the main loop
 float last_frame_time = 0.0f;
 float delta_time = 0.0f;
-float current_swap_time = 0.0f;
 float iteration_length = 0.1f;
 bool stopping = false;
 bool run = true;
+bool turbo = false;
+bool toggling_turbo = false;
 
 // fps counter variables
 float fps_sum = 0.0f;
@@ -75,45 +114,150 @@ float mouse_last_y = scr_width / 2.0f;
 bool taking_screenshot = false;
 Screen* screen_ptr;
 
+// metrics variables
+Metrics metrics;
+bool dumping_metrics = false;
+
 // camera pointer
 Camera* camera_ptr;
 
+// the generations are stepped on a thread of their own, the main loop only draws the newest one published
+Simulation* simulation_ptr;
+
+// checkpoint variables, the board of the kernel is written in the background when C is pressed
+KernelGL* kernel_ptr;
+CheckpointWriter* checkpoint_writer_ptr;
+bool checkpoints_supported = true;
+bool taking_checkpoint = false;
+
+// recording variables, R starts and stops recording every frame
+Recorder* recorder_ptr = nullptr;
+std::string record_directory = "recordings", record_pipe;
+bool toggling_recording = false;
+#endif
+
 int main(int argc, const char * argv[]) {
+    if(argc > 1 && strcmp(argv[1], "--headless") == 0) return runHeadless(argc, argv);
+    if(argc > 1 && strcmp(argv[1], "--ensemble") == 0) return runEnsemble(argc, argv);
+    if(argc > 1 && strcmp(argv[1], "--benchmark") == 0) return runBenchmarkMode(argc, argv);
+    if(argc > 1 && strcmp(argv[1], "--distributed") == 0) return runDistributedMode(argc, argv);
+    
+    #ifdef CPU_ONLY
+    std::cerr << "ERROR: BUILT WITH CPU_ONLY, THE WINDOW NEEDS OpenGL AND OpenCL: RUN WITH --headless, --ensemble, --benchmark OR --distributed" << std::endl;
+    return -1;
+    #else
+    return runWindow(argc, argv);
+    #endif
+}
+
+#ifndef CPU_ONLY
+// the window: the board is stepped by OpenCL on the simulation thread and drawn by OpenGL
+int runWindow(int argc, const char* argv[]) {
+    // usage: Automata [--rule B3/S23] [--ltl R5,C0,M1,S34..58,B34..45,NM] [--lenia R13,T10,M0.15,S0.015,B1] [--metrics path] [--metrics-interval seconds] [--restore path] [--pattern path] [--record-dir path] [--record-pipe command] [--generations-per-launch K]
+    Rule rule;
+    std::string rule_ltl, rule_lenia;
+    std::string metrics_path;
+    std::string restore_path, pattern_path;
+    float metrics_interval = 10.0f;
+    unsigned int generations_per_launch = 1;
+    bool rule_given = false;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        if(strcmp(argv[i], "--rule") == 0) {
+            rule = parseRule(argv[i + 1]);
+            rule_given = true;
+        }
+        else if(strcmp(argv[i], "--ltl") == 0) rule_ltl = argv[i + 1];
+        else if(strcmp(argv[i], "--lenia") == 0) rule_lenia = argv[i + 1];
+        else if(strcmp(argv[i], "--metrics") == 0) metrics_path = argv[i + 1];
+        else if(strcmp(argv[i], "--metrics-interval") == 0) metrics_interval = std::stof(argv[i + 1]);
+        else if(strcmp(argv[i], "--restore") == 0) restore_path = argv[i + 1];
+        else if(strcmp(argv[i], "--pattern") == 0) pattern_path = argv[i + 1];
+        else if(strcmp(argv[i], "--record-dir") == 0) record_directory = argv[i + 1];
+        else if(strcmp(argv[i], "--record-pipe") == 0) record_pipe = argv[i + 1];
+        else if(strcmp(argv[i], "--generations-per-launch") == 0) generations_per_launch = (unsigned int)std::stoul(argv[i + 1]);
+    }
+    
     GLFWwindow* window = initialiseOpenGL();
     
     Screen screen(scr_width, scr_height, "src/shaders/screen/screen.vs", "src/shaders/screen/screen.fs", "src/shaders/automata/automata.vs", "src/shaders/automata/automata.fs");
     screen_ptr = &screen;
     
     KernelGL kernel("src/kernels/kernel_automata.ocl", "iterate");
-    kernel.createImagesGL("textures/die4.png", "processTexture");
+    kernel_ptr = &kernel;
+    checkpoints_supported = rule_ltl.empty() && rule_lenia.empty();
+    
+    if(!restore_path.empty()) {
+        // the rule of the checkpoint unless --rule is given, the generation counter carries on from the checkpoint
+        CheckpointReader reader(restore_path);
+        std::vector<unsigned char> cells;
+        reader.read(cells);
+        
+        kernel.setRule(rule_given ? rule : reader.rule());
+        kernel.load(cells.data(), reader.width(), reader.height());
+        kernel.generation = reader.header.generation;
+    } else if(!pattern_path.empty()) {
+        // an RLE or a Macrocell file, with its own rule unless --rule is given
+        std::unique_ptr<Pattern> pattern(openPattern(pattern_path));
+        kernel.setRule(rule_given || !pattern->rule_found ? rule : pattern->rule);
+        pattern->load(kernel);
+    } else {
+        kernel.setRule(rule);
+        kernel.createImagesGL("textures/die4.png", "processTexture");
+    }
+    if(!rule_ltl.empty()) kernel.setRuleLtL(parseRuleLtL(rule_ltl));
+    if(!rule_lenia.empty()) kernel.setRuleLenia(parseRuleLenia(rule_lenia));
+    kernel.setGenerationsPerLaunch(generations_per_launch);
+    
+    CheckpointWriter checkpoint_writer;
+    checkpoint_writer_ptr = &checkpoint_writer;
     
     Camera camera(scr_width, scr_height, kernel.width, kernel.height);
     camera_ptr = &camera;
     
+    // the stages are timed all the time, M prints them and --metrics writes them to a file every metrics_interval seconds
+    kernel.setMetrics(&metrics);
+    screen.setMetrics(&metrics);
+    
+    kernel.setDecoupled(true);
+    Simulation simulation(kernel, iteration_length);
+    simulation.setMetrics(&metrics);
+    simulation_ptr = &simulation;
+    float last_metrics_time = 0.0f;
+    
     while(!glfwWindowShouldClose(window)) {
         float current_time = glfwGetTime();
         delta_time = current_time - last_frame_time;
         last_frame_time = current_time;
-        current_swap_time += delta_time;
+        metrics.record("frame", delta_time);
+        
+        if(!metrics_path.empty() && current_time - last_metrics_time > metrics_interval) {
+            metrics.writePrometheusFile(metrics_path);
+            last_metrics_time = current_time;
+        }
         
         processInput(window);
         
         camera.transferData(screen.automata_shader, "pos_x", "pos_y", "width_inv", "height_inv");
         
         kernel.transferData(screen.automata_shader, "automata");
+        kernel.transferDensity(screen.automata_shader, "density", camera);
         screen.draw();
+        if(recorder_ptr) screen.record(*recorder_ptr);
         
-        glFinish();
-        
-        if(run && current_swap_time > iteration_length) {
-            kernel.iterate();
-            current_swap_time = 0.0f;
-        }
+        // flush the draw calls, the simulation thread takes the display image drawn only once the next frame has moved on to a newer one
+        glFlush();
         
+        auto swap_start = std::chrono::steady_clock::now();
         glfwSwapBuffers(window);
+        metrics.record("swap_buffers", std::chrono::duration<double>(std::chrono::steady_clock::now() - swap_start).count());
+        
         glfwPollEvents();
     }
     
+    if(!metrics_path.empty()) metrics.writePrometheusFile(metrics_path);
+    
+    simulation.stop(); // the batch in progress is finished while OpenGL is still there
+    delete recorder_ptr; // the frames still in flight are written first
     glfwTerminate();
     return 0;
 }
@@ -133,10 +277,12 @@ void processInput(GLFWwindow* window) {
     if(glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS) {
         iteration_length *= exp(-delta_time * ITERATION_LENGTH_STRENGTH);
         if(iteration_length < ITERATION_LENGTH_MIN) iteration_length = ITERATION_LENGTH_MIN;
+        simulation_ptr->setIterationLength(iteration_length);
         std::cout << "Changed iteration length to: " << iteration_length << " s" << std::endl;
     } else if(glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS) {
         iteration_length *= exp(delta_time * ITERATION_LENGTH_STRENGTH);
         if(iteration_length > ITERATION_LENGTH_MAX) iteration_length = ITERATION_LENGTH_MAX;
+        simulation_ptr->setIterationLength(iteration_length);
         std::cout << "Changed iteration length to: " << iteration_length << " s" << std::endl;
     }
     
@@ -148,11 +294,47 @@ void processInput(GLFWwindow* window) {
     }
     
     if(glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-        if(!stopping) run = !run;
+        if(!stopping) {
+            run = !run;
+            simulation_ptr->setRunning(run);
+        }
         stopping = true;
     } else if(glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE) {
         stopping = false;
     }
+    
+    // turbo: as many generations as the engine can run, whatever the iteration length
+    if(glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS) {
+        if(!toggling_turbo) {
+            turbo = !turbo;
+            simulation_ptr->setTurbo(turbo);
+            std::cout << "Turbo: " << (turbo ? "on" : "off") << std::endl;
+        }
+        toggling_turbo = true;
+    } else if(glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE) {
+        toggling_turbo = false;
+    }
+    
+    if(glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS) {
+        if(!dumping_metrics) metrics.dump(std::cout);
+        dumping_metrics = true;
+    } else if(glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE) {
+        dumping_metrics = false;
+    }
+    
+    if(glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
+        if(!toggling_recording) toggleRecording();
+        toggling_recording = true;
+    } else if(glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE) {
+        toggling_recording = false;
+    }
+    
+    if(glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
+        if(!taking_checkpoint) takeCheckpoint();
+        taking_checkpoint = true;
+    } else if(glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+        taking_checkpoint = false;
+    }
 }
 
 void mouseCallback(GLFWwindow* window, double pos_x, double pos_y) {
@@ -186,6 +368,42 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
     }
 }
 
+// every recording goes to a directory of its own, or to a new run of the encoder
+void toggleRecording() {
+    if(recorder_ptr) {
+        delete recorder_ptr;
+        recorder_ptr = nullptr;
+        return;
+    }
+    
+    std::string directory = record_directory + "/recording_" + std::to_string(time(nullptr));
+    if(record_pipe.empty()) mkdir(record_directory.c_str(), 0755); // fails harmlessly when it exists
+    
+    recorder_ptr = new Recorder(directory, record_pipe);
+    recorder_ptr->setMetrics(&metrics);
+    std::cout << "SUCCESS: RECORDER: RECORDING TO: " << (record_pipe.empty() ? directory : record_pipe) << std::endl;
+}
+
+// read the board and leave the encoding and the writing to the background thread
+void takeCheckpoint() {
+    if(!checkpoints_supported || kernel_ptr->rule.states > 2) {
+        std::cerr << "ERROR: CHECKPOINT: ONLY THE TWO-STATE LIFE-LIKE RULES ARE CHECKPOINTED" << std::endl;
+        return;
+    }
+    
+    mkdir("checkpoints", 0755); // fails harmlessly when it exists
+    
+    // the simulation thread stays off the kernel while the board is read
+    simulation_ptr->pause();
+    std::string path = "checkpoints/checkpoint_" + std::to_string(kernel_ptr->generation) + ".ckpt";
+    std::vector<unsigned char> cells((size_t)kernel_ptr->width * kernel_ptr->height);
+    kernel_ptr->read(cells.data());
+    checkpoint_writer_ptr->submit(path, std::move(cells), kernel_ptr->width, kernel_ptr->height, kernel_ptr->rule, kernel_ptr->generation);
+    simulation_ptr->resume();
+    
+    std::cout << "SUCCESS: CHECKPOINT: WRITING: " << path << std::endl;
+}
+
 void countFPS(float delta_time) {
     
     // count fps
@@ -196,9 +414,587 @@ void countFPS(float delta_time) {
     fps_sum += delta_time;
     fps_steps_counter++;
 }
+#endif
+
+// run the simulation on one of the CPU backends, or on all the OpenCL devices with opencl-multi, without showing a window - opencl needs an OpenGL context and opens a hidden one
+// usage: Automata --headless [--engine cpu] [--rule B3/S23] [--ltl R5,C0,M1,S34..58,B34..45,NM] [--lenia R13,T10,M0.15,S0.015,B1] [--threads N] [--generations N] [--texture path] [--scaling max_threads] [--step-log K] [--halo K] [--generations-per-launch K] [--restore path] [--checkpoint path] [--checkpoint-every N] [--pattern path] [--board WxH] [--export directory] [--export-every N] [--export-size WxH] [--export-region X,Y,W,H] [--export-threads N]
+// --export writes a PNG of the board every N generations, coloured like the window, of the region of cells X,Y,W,H (the whole board by default) scaled to WxH (one pixel per cell by default)
+// --pattern starts from an RLE or a Macrocell (.mc) file streamed into the engine, centred on a board of --board WxH (the size of the pattern by default)
+// --restore starts from a checkpoint instead of the texture, --checkpoint writes one at the end, or every N generations in the background while the board is stepped
+int runHeadless(int argc, const char* argv[]) {
+    std::string engine_name = "cpu";
+    std::string texture_path = "textures/die4.png";
+    Rule rule;
+    std::string rule_ltl, rule_lenia;
+    unsigned int threads_num = 0;
+    unsigned int generations = 1000;
+    bool scaling = false;
+    int step_log = -1;
+    int halo = 1;
+    unsigned int generations_per_launch = 1;
+    std::string restore_path, checkpoint_path;
+    unsigned int checkpoint_every = 0;
+    bool rule_given = false;
+    std::string pattern_path;
+    int board_width = 0, board_height = 0;
+    std::string export_path;
+    unsigned int export_every = 1, export_threads = 0;
+    int export_width = 0, export_height = 0;
+    int region[4] = {0, 0, 0, 0};
+    
+    for(int i = 2; i < argc; i++) {
+        if(i + 1 >= argc) {
+            std::cerr << "ERROR: HEADLESS: MISSING VALUE FOR: " << argv[i] << std::endl;
+            return -1;
+        }
+        
+        if(strcmp(argv[i], "--engine") == 0) engine_name = argv[++i];
+        else if(strcmp(argv[i], "--rule") == 0) {
+            rule = parseRule(argv[++i]);
+            rule_given = true;
+        }
+        else if(strcmp(argv[i], "--ltl") == 0) {
+            rule_ltl = argv[++i];
+            engine_name = "ltl";
+        }
+        else if(strcmp(argv[i], "--lenia") == 0) {
+            rule_lenia = argv[++i];
+            engine_name = "lenia";
+        }
+        else if(strcmp(argv[i], "--threads") == 0) threads_num = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--generations") == 0) generations = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--texture") == 0) texture_path = argv[++i];
+        else if(strcmp(argv[i], "--scaling") == 0) {
+            scaling = true;
+            threads_num = (unsigned int)std::stoul(argv[++i]);
+        } else if(strcmp(argv[i], "--step-log") == 0) step_log = std::stoi(argv[++i]);
+        else if(strcmp(argv[i], "--halo") == 0) halo = std::stoi(argv[++i]);
+        else if(strcmp(argv[i], "--generations-per-launch") == 0) generations_per_launch = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--restore") == 0) restore_path = argv[++i];
+        else if(strcmp(argv[i], "--checkpoint") == 0) checkpoint_path = argv[++i];
+        else if(strcmp(argv[i], "--checkpoint-every") == 0) checkpoint_every = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--pattern") == 0) pattern_path = argv[++i];
+        else if(strcmp(argv[i], "--board") == 0) {
+            if(sscanf(argv[++i], "%dx%d", &board_width, &board_height) != 2) {
+                std::cerr << "ERROR: HEADLESS: WRONG BOARD SIZE: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else if(strcmp(argv[i], "--export") == 0) export_path = argv[++i];
+        else if(strcmp(argv[i], "--export-every") == 0) export_every = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--export-threads") == 0) export_threads = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--export-size") == 0) {
+            if(sscanf(argv[++i], "%dx%d", &export_width, &export_height) != 2 || export_width < 1 || export_height < 1) {
+                std::cerr << "ERROR: HEADLESS: WRONG EXPORT SIZE: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else if(strcmp(argv[i], "--export-region") == 0) {
+            if(sscanf(argv[++i], "%d,%d,%d,%d", &region[0], &region[1], &region[2], &region[3]) != 4 || region[2] < 1 || region[3] < 1) {
+                std::cerr << "ERROR: HEADLESS: WRONG EXPORT REGION: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else {
+            std::cerr << "ERROR: HEADLESS: UNKNOWN OPTION: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+    
+    if((!restore_path.empty() || !checkpoint_path.empty()) && (!rule_ltl.empty() || !rule_lenia.empty())) {
+        std::cerr << "ERROR: HEADLESS: CHECKPOINTS HOLD ONLY THE LIFE-LIKE RULES, NOT --ltl OR --lenia" << std::endl;
+        return -1;
+    }
+    if(checkpoint_every > 0 && (checkpoint_path.empty() || step_log >= 0)) {
+        std::cerr << "ERROR: HEADLESS: --checkpoint-every NEEDS --checkpoint AND CANNOT BE USED WITH --step-log" << std::endl;
+        return -1;
+    }
+    if(!export_path.empty() && (export_every == 0 || step_log >= 0)) {
+        std::cerr << "ERROR: HEADLESS: --export NEEDS --export-every ABOVE 0 AND CANNOT BE USED WITH --step-log" << std::endl;
+        return -1;
+    }
+    if(generations_per_launch > 1 && engine_name != "opencl") {
+        std::cerr << "ERROR: HEADLESS: --generations-per-launch NEEDS THE opencl ENGINE, opencl-multi TAKES --halo" << std::endl;
+        return -1;
+    }
+    if(halo != 1 && engine_name != "opencl-multi") {
+        std::cerr << "ERROR: HEADLESS: --halo NEEDS THE opencl-multi ENGINE" << std::endl;
+        return -1;
+    }
+    
+    int width, height;
+    std::vector<unsigned char> cells;
+    unsigned long long generation_restored = 0;
+    std::unique_ptr<Pattern> pattern;
+    if(!pattern_path.empty()) {
+        // the cells are streamed into the engine when it is loaded, the board is only read into bytes at the end
+        pattern.reset(openPattern(pattern_path));
+        pattern->place(board_width, board_height);
+        width = pattern->board_width;
+        height = pattern->board_height;
+        if(!rule_given && pattern->rule_found) rule = pattern->rule;
+    } else if(!restore_path.empty()) {
+        CheckpointReader reader(restore_path);
+        reader.read(cells);
+        width = reader.width();
+        height = reader.height();
+        generation_restored = reader.header.generation;
+        if(!rule_given) rule = reader.rule();
+    } else {
+        loadImageState(texture_path.c_str(), cells, width, height);
+    }
+    
+    if(!checkpoint_path.empty() && rule.states > 2) {
+        std::cerr << "ERROR: HEADLESS: CHECKPOINTS HOLD ONLY THE TWO-STATE RULES, NOT: " << ruleString(rule) << std::endl;
+        return -1;
+    }
+    
+    // HashLife reports the population and the hash of its quadtree, the board is read into one byte per cell only for the other engines, the checkpoints, the exports and the scaling
+    bool read_board = (engine_name != "hashlife" && engine_name != "hashlife-plane") || !checkpoint_path.empty() || !export_path.empty() || scaling;
+    if(read_board && (unsigned long long)width * height > HEADLESS_READ_MAX) {
+        std::cerr << "ERROR: HEADLESS: THE BOARD OF " << width << "x" << height << " CELLS IS TOO LARGE TO READ INTO BYTES, RUN IT ON hashlife OR hashlife-plane WITHOUT --checkpoint, --export AND --scaling" << std::endl;
+        return -1;
+    }
+    
+    if(scaling) {
+        if(pattern) {
+            cells.assign((size_t)width * height, 0);
+            pattern->forEachRun([&cells, width](int x, int y, int length) { memset(&cells[(size_t)y * width + x], 1, length); });
+        }
+        runScaling(engine_name, rule, rule_ltl, rule_lenia, cells, width, height, generations, defaultThreadsNum(threads_num));
+        return 0;
+    }
+    
+    #ifdef CPU_ONLY
+    Engine* engine = createEngine(engine_name, threads_num);
+    #else
+    Engine* engine;
+    GLFWwindow* window = NULL;
+    if(engine_name == "opencl") {
+        window = initialiseOpenGL(false);
+        KernelGL* kernel = new KernelGL("src/kernels/kernel_automata.ocl", "iterate");
+        kernel->setGenerationsPerLaunch(generations_per_launch);
+        engine = kernel;
+    }
+    else if(engine_name == "opencl-multi") engine = new KernelMulti("src/kernels/kernel_automata.ocl", halo);
+    else engine = createEngine(engine_name, threads_num);
+    #endif
+    std::string rule_string = setEngineRule(engine, rule, rule_ltl, rule_lenia);
+    
+    auto load_start = std::chrono::steady_clock::now();
+    if(pattern) pattern->load(*engine);
+    else engine->load(cells.data(), width, height);
+    std::chrono::duration<double> load_time = std::chrono::steady_clock::now() - load_start;
+    
+    std::cout << "SUCCESS: HEADLESS: USING ENGINE: " << engine->name() << ", rule: " << rule_string << ", board: " << width << "x" << height << ", load time: " << load_time.count() << " s" << std::endl;
+    
+    CheckpointWriter checkpoint_writer;
+    
+    std::unique_ptr<Exporter> exporter;
+    if(!export_path.empty()) {
+        ExportView view;
+        if(region[2] > 0) view = exportRegion(region[0], region[1], region[2], region[3], width, height);
+        if(export_width == 0 && region[2] > 0) {
+            export_width = region[2];
+            export_height = region[3];
+        }
+        exporter.reset(new Exporter(export_path, export_threads, view, export_width, export_height));
+        exporter->submit(*engine, generation_restored);
+    }
+    
+    auto start_time = std::chrono::steady_clock::now();
+    if(step_log >= 0) {
+        // jump 2^step_log generations at once, only HashLife can skip generations
+        EngineHashLife* engine_hashlife = dynamic_cast<EngineHashLife*>(engine);
+        if(!engine_hashlife) {
+            std::cerr << "ERROR: HEADLESS: --step-log NEEDS THE hashlife OR hashlife-plane ENGINE" << std::endl;
+            return -1;
+        }
+        engine_hashlife->stepExponential((unsigned int)step_log);
+    } else {
+        // stop only for the checkpoints and the exported frames, both are written in the background while the next generations are stepped
+        for(unsigned int stepped = 0; stepped < generations;) {
+            unsigned int k = generations - stepped;
+            if(checkpoint_every > 0) k = std::min(k, checkpoint_every - stepped % checkpoint_every);
+            if(exporter) k = std::min(k, export_every - stepped % export_every);
+            
+            engine->step(k);
+            stepped += k;
+            
+            if(checkpoint_every > 0 && stepped % checkpoint_every == 0) {
+                // a newer checkpoint replaces one still waiting for the writer
+                std::vector<unsigned char> snapshot((size_t)width * height);
+                engine->read(snapshot.data());
+                checkpoint_writer.submit(checkpoint_path, std::move(snapshot), width, height, engine->rule, generation_restored + engine->generation);
+            }
+            if(exporter && stepped % export_every == 0) exporter->submit(*engine, generation_restored + engine->generation);
+        }
+    }
+    std::chrono::duration<double> run_time = std::chrono::steady_clock::now() - start_time;
+    
+    uint64_t population, hash;
+    if(read_board) {
+        cells.resize((size_t)width * height);
+        engine->read(cells.data());
+        population = statePopulation(cells.data(), width, height);
+        hash = stateHash(cells.data(), width, height);
+    } else {
+        EngineHashLife* engine_hashlife = static_cast<EngineHashLife*>(engine);
+        population = engine_hashlife->boardPopulation();
+        hash = engine_hashlife->quadtreeHash();
+    }
+    
+    if(!checkpoint_path.empty()) {
+        if(checkpoint_every == 0) writeCheckpoint(checkpoint_path, cells.data(), width, height, engine->rule, generation_restored + engine->generation);
+        checkpoint_writer.wait();
+        std::cout << "SUCCESS: HEADLESS: CHECKPOINT WRITTEN: " << checkpoint_path << std::endl;
+    }
+    
+    if(exporter) {
+        exporter->wait();
+        std::cout << "SUCCESS: HEADLESS: FRAMES EXPORTED: " << exporter->framesWritten() << ", time waiting for the encoders: " << exporter->waitTime() << " s" << std::endl;
+    }
+    
+    std::cout << "Generations: " << generation_restored + engine->generation << ", time: " << run_time.count() << " s, ";
+    std::cout << "generations/s: " << engine->generation / run_time.count() << ", population: " << population << (read_board ? ", hash: " : ", quadtree hash: ") << std::hex << hash << std::dec << std::endl;
+    
+    delete engine;
+    #ifndef CPU_ONLY
+    if(window) glfwTerminate();
+    #endif
+    return 0;
+}
+
+// step many small random soups at once and print one line per board, for the parameter sweeps
+// usage: Automata --ensemble boards_num [--engine cpu] [--board side] [--rule B3/S23,B36/S23,...] [--seed S] [--density D] [--threads N] [--generations N]
+// the rules are given to the boards in turn, board b starts from the soup of the seed S + b; --engine opencl steps all the boards in one launch per generation
+int runEnsemble(int argc, const char* argv[]) {
+    if(argc < 3) {
+        std::cerr << "ERROR: ENSEMBLE: MISSING NUMBER OF BOARDS" << std::endl;
+        return -1;
+    }
+    
+    int boards_num = std::stoi(argv[2]);
+    std::string engine_name = "cpu";
+    std::string rules_string = "B3/S23";
+    int side = 256;
+    uint64_t seed = 1;
+    float density = 0.5f;
+    unsigned int threads_num = 0;
+    unsigned int generations = 1000;
+    
+    for(int i = 3; i < argc; i++) {
+        if(i + 1 >= argc) {
+            std::cerr << "ERROR: ENSEMBLE: MISSING VALUE FOR: " << argv[i] << std::endl;
+            return -1;
+        }
+        
+        if(strcmp(argv[i], "--engine") == 0) engine_name = argv[++i];
+        else if(strcmp(argv[i], "--board") == 0) side = std::stoi(argv[++i]);
+        else if(strcmp(argv[i], "--rule") == 0) rules_string = argv[++i];
+        else if(strcmp(argv[i], "--seed") == 0) seed = std::stoull(argv[++i]);
+        else if(strcmp(argv[i], "--density") == 0) density = std::stof(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0) threads_num = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--generations") == 0) generations = (unsigned int)std::stoul(argv[++i]);
+        else {
+            std::cerr << "ERROR: ENSEMBLE: UNKNOWN OPTION: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+    
+    if(boards_num < 1 || side < 1) {
+        std::cerr << "ERROR: ENSEMBLE: WRONG NUMBER OR SIZE OF BOARDS" << std::endl;
+        return -1;
+    }
+    
+    std::vector<Rule> rules_list;
+    for(const std::string& rule : splitList(rules_string)) rules_list.push_back(parseRule(rule));
+    
+    size_t board_size = (size_t)side * side;
+    std::vector<unsigned char> cells(board_size * boards_num);
+    std::vector<Rule> rules(boards_num);
+    for(int b = 0; b < boards_num; b++) {
+        ensembleSoup(&cells[board_size * b], side, side, seed + b, density);
+        rules[b] = rules_list[b % rules_list.size()];
+    }
+    
+    Ensemble* ensemble;
+    #ifdef CPU_ONLY
+    ensemble = new EnsembleCPU(engine_name, threads_num);
+    #else
+    if(engine_name == "opencl") ensemble = new EnsembleCL("src/kernels/kernel_automata.ocl");
+    else ensemble = new EnsembleCPU(engine_name, threads_num);
+    #endif
+    
+    ensemble->load(cells.data(), rules.data(), side, side, boards_num);
+    
+    std::cout << "SUCCESS: ENSEMBLE: USING ENGINE: " << ensemble->name() << ", boards: " << boards_num << ", board: " << side << "x" << side << std::endl;
+    
+    auto start_time = std::chrono::steady_clock::now();
+    ensemble->step(generations);
+    std::chrono::duration<double> run_time = std::chrono::steady_clock::now() - start_time;
+    
+    ensemble->read(cells.data());
+    
+    std::cout << "Generations: " << ensemble->generation << ", time: " << run_time.count() << " s, ";
+    std::cout << "cells/s: " << (double)ensemble->generation * board_size * boards_num / run_time.count() << std::endl;
+    
+    std::cout << "board, seed, rule, population, hash" << std::endl;
+    for(int b = 0; b < boards_num; b++) {
+        const unsigned char* board = &cells[board_size * b];
+        std::cout << b << ", " << seed + b << ", " << ruleString(rules[b]) << ", " << statePopulation(board, side, side) << ", " << std::hex << stateHash(board, side, side) << std::dec << std::endl;
+    }
+    
+    delete ensemble;
+    return 0;
+}
+
+// split a comma-separated list of the command line
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    size_t begin = 0;
+    while(begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if(end == std::string::npos) end = list.size();
+        items.push_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
+// run every engine over the matrix of board sizes, densities and rules, print the measurements as CSV or JSON and check that all the engines end in the same state
+// usage: Automata --benchmark [--engines cpu,simd,...] [--sizes 256,1024] [--densities 0.25,0.5] [--rules B3/S23,B36/S23] [--seed S] [--generations N] [--warmup N] [--threads N] [--scaling max_threads] [--generations-per-launch K] [--format csv|json] [--output path]
+// opencl runs in a hidden window, as it needs an OpenGL context; the exit code is 1 when the final states differ
+// opencl-kK advances K generations per launch of the kernel, --generations-per-launch K runs it next to opencl, which launches once per generation
+int runBenchmarkMode(int argc, const char* argv[]) {
+    BenchmarkConfig config;
+    std::string output_path;
+    unsigned int generations_per_launch = 1;
+    
+    for(int i = 2; i < argc; i++) {
+        if(i + 1 >= argc) {
+            std::cerr << "ERROR: BENCHMARK: MISSING VALUE FOR: " << argv[i] << std::endl;
+            return -1;
+        }
+        
+        if(strcmp(argv[i], "--engines") == 0) config.engines = splitList(argv[++i]);
+        else if(strcmp(argv[i], "--sizes") == 0) {
+            config.sizes.clear();
+            for(const std::string& size : splitList(argv[++i])) config.sizes.push_back(std::stoi(size));
+        } else if(strcmp(argv[i], "--densities") == 0) {
+            config.densities.clear();
+            for(const std::string& density : splitList(argv[++i])) config.densities.push_back(std::stof(density));
+        } else if(strcmp(argv[i], "--rules") == 0) {
+            config.rules.clear();
+            for(const std::string& rule : splitList(argv[++i])) config.rules.push_back(parseRule(rule));
+        }
+        else if(strcmp(argv[i], "--seed") == 0) config.seed = std::stoull(argv[++i]);
+        else if(strcmp(argv[i], "--generations") == 0) config.generations = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--warmup") == 0) config.warmup = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0) config.threads_num = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--scaling") == 0) config.scaling_max = defaultThreadsNum((unsigned int)std::stoul(argv[++i]));
+        else if(strcmp(argv[i], "--generations-per-launch") == 0) generations_per_launch = (unsigned int)std::stoul(argv[++i]);
+        else if(strcmp(argv[i], "--format") == 0) config.json = strcmp(argv[++i], "json") == 0;
+        else if(strcmp(argv[i], "--output") == 0) output_path = argv[++i];
+        else {
+            std::cerr << "ERROR: BENCHMARK: UNKNOWN OPTION: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+    
+    if(generations_per_launch > 1) {
+        // the blocked kernel is measured against the launch per generation, on the same cases
+        std::vector<std::string>::iterator opencl = std::find(config.engines.begin(), config.engines.end(), "opencl");
+        if(opencl == config.engines.end()) opencl = config.engines.insert(opencl, "opencl");
+        config.engines.insert(opencl + 1, "opencl-k" + std::to_string(generations_per_launch));
+    }
+    
+    #ifdef CPU_ONLY
+    BenchmarkEngineFactory create_engine = [](const std::string& engine_name, unsigned int threads_num) -> Engine* {
+        return createEngine(engine_name, threads_num);
+    };
+    #else
+    // the OpenGL context is created once, with the first OpenCL run
+    GLFWwindow* window = NULL;
+    BenchmarkEngineFactory create_engine = [&window](const std::string& engine_name, unsigned int threads_num) -> Engine* {
+        if(engine_name == "opencl-multi") return new KernelMulti("src/kernels/kernel_automata.ocl");
+        if(engine_name != "opencl" && engine_name.compare(0, 8, "opencl-k") != 0) return createEngine(engine_name, threads_num);
+        if(!window) window = initialiseOpenGL(false);
+        KernelGL* kernel = new KernelGL("src/kernels/kernel_automata.ocl", "iterate");
+        if(engine_name != "opencl") kernel->setGenerationsPerLaunch((unsigned int)std::stoul(engine_name.substr(8)));
+        return kernel;
+    };
+    #endif
+    
+    std::vector<BenchmarkResult> results = runBenchmark(config, create_engine);
+    
+    if(output_path.empty()) writeBenchmark(results, config.json, std::cout);
+    else {
+        std::ofstream output_file(output_path);
+        if(!output_file) {
+            std::cerr << "ERROR: BENCHMARK: CANNOT WRITE TO: " << output_path << std::endl;
+            return -1;
+        }
+        writeBenchmark(results, config.json, output_file);
+    }
+    
+    #ifndef CPU_ONLY
+    if(window) glfwTerminate();
+    #endif
+    
+    if(!benchmarkHashesAgree(results)) {
+        std::cerr << "ERROR: BENCHMARK: THE ENGINES ENDED IN DIFFERENT STATES, SEE hash_ok" << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
-GLFWwindow* initialiseOpenGL() {
+// step one board with several worker processes, each owning a strip of rows and exchanging its boundary rows with the neighbours every generation
+// usage: Automata --distributed workers_num [--transport shm|tcp] [--strip WxH] [--rule B3/S23] [--seed S] [--density D] [--generations N] [--scaling] [--check]
+// the board is W x (H * workers_num), --scaling runs 1, 2, 4, ... workers on strips of the same size (weak scaling), --check compares the board with the cpu engine
+int runDistributedMode(int argc, const char* argv[]) {
+    if(argc < 3) {
+        std::cerr << "ERROR: DISTRIBUTED: MISSING NUMBER OF WORKERS" << std::endl;
+        return -1;
+    }
+    
+    DistributedConfig config;
+    int workers_max = std::stoi(argv[2]);
+    bool scaling = false, check = false;
+    
+    for(int i = 3; i < argc; i++) {
+        if(strcmp(argv[i], "--scaling") == 0) {
+            scaling = true;
+            continue;
+        }
+        if(strcmp(argv[i], "--check") == 0) {
+            check = true;
+            continue;
+        }
+        
+        if(i + 1 >= argc) {
+            std::cerr << "ERROR: DISTRIBUTED: MISSING VALUE FOR: " << argv[i] << std::endl;
+            return -1;
+        }
+        
+        if(strcmp(argv[i], "--transport") == 0) config.tcp = strcmp(argv[++i], "tcp") == 0;
+        else if(strcmp(argv[i], "--strip") == 0) {
+            if(sscanf(argv[++i], "%dx%d", &config.width, &config.rows) != 2) {
+                std::cerr << "ERROR: DISTRIBUTED: WRONG STRIP SIZE: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else if(strcmp(argv[i], "--rule") == 0) config.rule = parseRule(argv[++i]);
+        else if(strcmp(argv[i], "--seed") == 0) config.seed = std::stoull(argv[++i]);
+        else if(strcmp(argv[i], "--density") == 0) config.density = std::stof(argv[++i]);
+        else if(strcmp(argv[i], "--generations") == 0) config.generations = (unsigned int)std::stoul(argv[++i]);
+        else {
+            std::cerr << "ERROR: DISTRIBUTED: UNKNOWN OPTION: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+    
+    std::vector<int> workers_list;
+    if(scaling) for(int workers_num = 1; workers_num < workers_max; workers_num *= 2) workers_list.push_back(workers_num);
+    workers_list.push_back(workers_max);
+    
+    // the efficiency of the weak scaling is the time of the first line over the time of each line
+    std::cout << "workers, transport, board, generations, time_s, cells/s, efficiency, hash" << std::endl;
+    
+    double time_first = 0.0;
+    bool states_agree = true;
+    for(int workers_num : workers_list) {
+        config.workers_num = workers_num;
+        int height = config.rows * workers_num;
+        
+        std::vector<unsigned char> cells;
+        double time_s = runDistributed(config, cells);
+        if(time_first == 0.0) time_first = time_s;
+        
+        uint64_t hash = stateHash(cells.data(), config.width, height);
+        std::cout << workers_num << ", " << (config.tcp ? "tcp" : "shm") << ", " << config.width << "x" << height << ", " << config.generations << ", " << time_s << ", ";
+        std::cout << (double)config.generations * config.width * height / time_s << ", " << time_first / time_s << ", " << std::hex << hash << std::dec << std::endl;
+        
+        if(check) {
+            std::vector<unsigned char> cells_check((size_t)config.width * height);
+            ensembleSoup(cells_check.data(), config.width, height, config.seed, config.density);
+            
+            Engine* engine = createEngine("cpu");
+            engine->setRule(config.rule);
+            engine->load(cells_check.data(), config.width, height);
+            engine->step(config.generations);
+            engine->read(cells_check.data());
+            delete engine;
+            
+            if(stateHash(cells_check.data(), config.width, height) != hash) {
+                std::cerr << "ERROR: DISTRIBUTED: " << workers_num << " WORKERS ENDED IN A DIFFERENT STATE THAN THE cpu ENGINE" << std::endl;
+                states_agree = false;
+            }
+        }
+    }
+    
+    return states_agree ? 0 : 1;
+}
+
+// set the rule given on the command line and return it in its notation, the Larger-than-Life and the Lenia rules need their own engines
+std::string setEngineRule(Engine* engine, const Rule& rule, const std::string& rule_ltl, const std::string& rule_lenia) {
+    engine->setRule(rule);
+    
+    if(!rule_ltl.empty()) {
+        EngineLtL* engine_ltl = dynamic_cast<EngineLtL*>(engine);
+        if(!engine_ltl) {
+            std::cerr << "ERROR: HEADLESS: --ltl NEEDS THE ltl ENGINE" << std::endl;
+            exit(-1);
+        }
+        engine_ltl->setRuleLtL(parseRuleLtL(rule_ltl));
+        return ruleStringLtL(engine_ltl->ruleLtL());
+    }
+    
+    if(!rule_lenia.empty()) {
+        EngineLenia* engine_lenia = dynamic_cast<EngineLenia*>(engine);
+        if(!engine_lenia) {
+            std::cerr << "ERROR: HEADLESS: --lenia NEEDS THE lenia ENGINE" << std::endl;
+            exit(-1);
+        }
+        engine_lenia->setRuleLenia(parseRuleLenia(rule_lenia));
+        return ruleStringLenia(engine_lenia->ruleLenia());
+    }
+    
+    return ruleString(rule);
+}
+
+// print the throughput of the engine for 1..threads_max threads, used for sizing the machines
+void runScaling(const std::string& engine_name, const Rule& rule, const std::string& rule_ltl, const std::string& rule_lenia, const std::vector<unsigned char>& cells, int width, int height, unsigned int generations, unsigned int threads_max) {
+    double generations_per_s_single = 0.0;
+    
+    std::cout << "threads, generations/s, cells/s, speedup, efficiency" << std::endl;
+    
+    for(unsigned int threads_num = 1; threads_num <= threads_max; threads_num++) {
+        Engine* engine = createEngine(engine_name, threads_num);
+        setEngineRule(engine, rule, rule_ltl, rule_lenia);
+        engine->load(cells.data(), width, height);
+        
+        // warm up the caches and the thread pool before measuring
+        engine->step(generations / 10 + 1);
+        
+        auto start_time = std::chrono::steady_clock::now();
+        engine->step(generations);
+        std::chrono::duration<double> run_time = std::chrono::steady_clock::now() - start_time;
+        
+        double generations_per_s = generations / run_time.count();
+        if(threads_num == 1) generations_per_s_single = generations_per_s;
+        double speedup = generations_per_s / generations_per_s_single;
+        
+        std::cout << threads_num << ", " << generations_per_s << ", " << generations_per_s * width * height << ", " << speedup << ", " << speedup / threads_num << std::endl;
+        
+        delete engine;
+    }
+}
+
+#ifndef CPU_ONLY
+GLFWwindow* initialiseOpenGL(bool visible) {
     glfwInit();
+    glfwWindowHint(GLFW_VISIBLE, visible ? GL_TRUE : GL_FALSE);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -237,3 +1033,4 @@ GLFWwindow* initialiseOpenGL() {
     
     return window;
 }
+#endif
@@ -0,0 +1,187 @@
+//
+//  benchmark.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef benchmark_h
+#define benchmark_h
+
+// include the standard libraries
+#include <vector>
+#include <string>
+#include <functional>
+#include <chrono>
+#include <ostream>
+#include <iomanip>
+#include <cstdint>
+
+#include "engine.h"
+#include "ensemble.h"
+
+// the engines, board sizes, densities and rules of the benchmark matrix, every case starts from the soup of the same seed
+struct BenchmarkConfig {
+    std::vector<std::string> engines;
+    std::vector<int> sizes; // square boards
+    std::vector<float> densities;
+    std::vector<Rule> rules;
+    uint64_t seed;
+    unsigned int generations, warmup;
+    unsigned int threads_num; // 0 for all the cores
+    unsigned int scaling_max; // the thread-scaling curve goes up to this number of threads, 0 for none
+    bool json;
+    
+    BenchmarkConfig() : engines({"cpu", "bitpacked", "simd", "tiled", "hashlife", "ltl", "opencl"}), sizes({256, 1024, 2048}), densities({0.25f, 0.5f}), rules({Rule(), Rule(RULE_HIGHLIFE_BIRTH, RULE_LIFE_SURVIVAL)}),
+                        seed(1), generations(100), warmup(10), threads_num(0), scaling_max(0), json(false) {}
+};
+
+// one measurement, kind is "run" for the matrix and "scaling" for the thread-scaling curve
+struct BenchmarkResult {
+    std::string kind, engine, rule;
+    int size;
+    float density;
+    unsigned int threads;
+    unsigned int generations;
+    double time_s, generations_per_s, cells_per_s, bytes_per_cell;
+    uint64_t hash;
+    bool hash_ok; // the same final state as the first engine of the case
+};
+
+// creates the engines, so that the callers can add the ones needing an OpenGL context
+typedef std::function<Engine*(const std::string&, unsigned int)> BenchmarkEngineFactory;
+
+// the engines refuse some of the cases: the bit and byte engines run only the two-state rules, HashLife only the boards with power-of-two sides and no B0,
+// the Larger-than-Life engine only the ranges of counts - the infinite plane of hashlife-plane and the Lenia states are not comparable with the torus
+inline bool benchmarkSupports(const std::string& engine_name, const Rule& rule, int size) {
+    RuleLtL rule_ltl;
+    
+    if(engine_name == "cpu" || engine_name == "opencl" || engine_name.compare(0, 8, "opencl-k") == 0) return true;
+    if(rule.states > 2) return false;
+    if(engine_name == "hashlife") return (size & (size - 1)) == 0 && (rule.birth & 1u) == 0;
+    if(engine_name == "ltl") return ruleToLtL(rule, rule_ltl);
+    return engine_name != "hashlife-plane" && engine_name != "lenia";
+}
+
+// the engines running a single thread whatever their thread count, left out of the scaling curve
+inline bool benchmarkThreaded(const std::string& engine_name) {
+    return engine_name.compare(0, 8, "hashlife") != 0 && engine_name.compare(0, 6, "opencl") != 0;
+}
+
+inline BenchmarkResult benchmarkEngine(const BenchmarkEngineFactory& create_engine, const std::string& engine_name, unsigned int threads_num, const Rule& rule,
+                                       const std::vector<unsigned char>& cells, int size, float density, const BenchmarkConfig& config) {
+    Engine* engine = create_engine(engine_name, threads_num);
+    engine->setRule(rule);
+    engine->load(cells.data(), size, size);
+    
+    // the warm-up fills the caches, the memo tables and the queues, it is not timed
+    engine->step(config.warmup);
+    
+    auto start_time = std::chrono::steady_clock::now();
+    engine->step(config.generations);
+    std::chrono::duration<double> run_time = std::chrono::steady_clock::now() - start_time;
+    
+    std::vector<unsigned char> cells_out((size_t)size * size);
+    engine->read(cells_out.data());
+    
+    BenchmarkResult result;
+    result.kind = "run";
+    result.engine = engine_name;
+    result.rule = ruleString(rule);
+    result.size = size;
+    result.density = density;
+    result.threads = benchmarkThreaded(engine_name) ? defaultThreadsNum(threads_num) : 1;
+    result.generations = config.generations;
+    result.time_s = run_time.count();
+    result.generations_per_s = config.generations / result.time_s;
+    result.cells_per_s = result.generations_per_s * size * size;
+    result.bytes_per_cell = engine->bytesPerCell();
+    result.hash = stateHash(cells_out.data(), size, size);
+    result.hash_ok = true;
+    
+    delete engine;
+    return result;
+}
+
+// run the whole matrix and the scaling curves, returns the measurements
+inline std::vector<BenchmarkResult> runBenchmark(const BenchmarkConfig& config, const BenchmarkEngineFactory& create_engine) {
+    std::vector<BenchmarkResult> results;
+    std::vector<unsigned char> cells;
+    
+    for(int size : config.sizes) for(float density : config.densities) for(const Rule& rule : config.rules) {
+        cells.resize((size_t)size * size);
+        ensembleSoup(cells.data(), size, size, config.seed, density);
+        
+        // the first engine of the case gives the reference hash
+        size_t case_begin = results.size();
+        
+        for(const std::string& engine_name : config.engines) {
+            if(!benchmarkSupports(engine_name, rule, size)) continue;
+            
+            results.push_back(benchmarkEngine(create_engine, engine_name, config.threads_num, rule, cells, size, density, config));
+            results.back().hash_ok = results.back().hash == results[case_begin].hash;
+            
+            std::cerr << "BENCHMARK: " << engine_name << ", " << results.back().rule << ", " << size << "x" << size << ", density " << density << ": " << results.back().generations_per_s << " generations/s" << std::endl;
+        }
+    }
+    
+    if(config.scaling_max == 0) return results;
+    
+    // the scaling curve on the largest board of the first case, 1, 2, 4, ... threads and the maximum
+    
+    int size = config.sizes.back();
+    float density = config.densities.front();
+    const Rule& rule = config.rules.front();
+    
+    cells.resize((size_t)size * size);
+    ensembleSoup(cells.data(), size, size, config.seed, density);
+    
+    std::vector<unsigned int> threads_list;
+    for(unsigned int threads_num = 1; threads_num < config.scaling_max; threads_num *= 2) threads_list.push_back(threads_num);
+    threads_list.push_back(config.scaling_max);
+    
+    for(const std::string& engine_name : config.engines) {
+        if(!benchmarkThreaded(engine_name) || !benchmarkSupports(engine_name, rule, size)) continue;
+        
+        size_t curve_begin = results.size();
+        for(unsigned int threads_num : threads_list) {
+            results.push_back(benchmarkEngine(create_engine, engine_name, threads_num, rule, cells, size, density, config));
+            results.back().kind = "scaling";
+            results.back().hash_ok = results.back().hash == results[curve_begin].hash;
+        }
+    }
+    
+    return results;
+}
+
+inline bool benchmarkHashesAgree(const std::vector<BenchmarkResult>& results) {
+    for(const BenchmarkResult& result : results) if(!result.hash_ok) return false;
+    return true;
+}
+
+// one line per measurement, in the same order and with the same columns every time, so that the files of two releases can be diffed
+inline void writeBenchmark(const std::vector<BenchmarkResult>& results, bool json, std::ostream& output) {
+    output << std::setprecision(6);
+    
+    if(!json) output << "kind, engine, rule, size, density, threads, generations, time_s, generations_per_s, cells_per_s, bytes_per_cell, hash, hash_ok" << std::endl;
+    else output << "[" << std::endl;
+    
+    for(size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+        
+        if(json) {
+            output << "  {\"kind\": \"" << result.kind << "\", \"engine\": \"" << result.engine << "\", \"rule\": \"" << result.rule << "\", \"size\": " << result.size;
+            output << ", \"density\": " << result.density << ", \"threads\": " << result.threads << ", \"generations\": " << result.generations << ", \"time_s\": " << result.time_s;
+            output << ", \"generations_per_s\": " << result.generations_per_s << ", \"cells_per_s\": " << result.cells_per_s << ", \"bytes_per_cell\": " << result.bytes_per_cell;
+            output << ", \"hash\": \"" << std::hex << result.hash << std::dec << "\", \"hash_ok\": " << (result.hash_ok ? "true" : "false") << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+        } else {
+            output << result.kind << ", " << result.engine << ", " << result.rule << ", " << result.size << ", " << result.density << ", " << result.threads << ", " << result.generations << ", " << result.time_s;
+            output << ", " << result.generations_per_s << ", " << result.cells_per_s << ", " << result.bytes_per_cell << ", " << std::hex << result.hash << std::dec << ", " << (result.hash_ok ? "true" : "false") << std::endl;
+        }
+    }
+    
+    if(json) output << "]" << std::endl;
+}
+
+#endif /* benchmark_h */
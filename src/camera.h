@@ -9,6 +9,10 @@
 #ifndef camera_h
 #define camera_h
 
+// include the standard libraries
+#include <cmath>
+#include <algorithm>
+
 #include "shader.h"
 
 #define ZOOM_MIN 1.0f
@@ -86,6 +90,21 @@ public:
         setTextureSize();
     }
     
+    // the part of the board shown, in the coordinates of the texture as automata.vs computes them - the board repeats outside of [0, 1)
+    void visibleRegion(float& u_min, float& v_min, float& u_size, float& v_size) const {
+        u_size = zoom_current / tex_width_n;
+        v_size = zoom_current / tex_height_n;
+        u_min = 0.5f - 0.5f * u_size - pos_x / scr_max;
+        v_min = 0.5f - 0.5f * v_size - pos_y / scr_max;
+    }
+    
+    // the level of detail of a board of tex_width x tex_height cells: log2 of the cells per pixel of the framebuffer rounded like OpenGL picks a mipmap, 0 when zoomed in
+    int level(int tex_width, int tex_height) const {
+        float cells_per_pixel = std::max(zoom_current / tex_width_n * tex_width / scr_width, zoom_current / tex_height_n * tex_height / scr_height);
+        if(cells_per_pixel < 1.0f) return 0;
+        return (int)std::floor(std::log2(cells_per_pixel) + 0.5f);
+    }
+    
     void transferData(Shader& shader, const std::string& pos_x_id, const std::string& pos_y_id, const std::string& width_id, const std::string& height_id) const {
         shader.use();
         
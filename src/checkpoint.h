@@ -0,0 +1,351 @@
+//
+//  checkpoint.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef checkpoint_h
+#define checkpoint_h
+
+// include the standard libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// include the POSIX libraries
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "engine.h"
+
+#define CHECKPOINT_VERSION 1u
+#define CHECKPOINT_TILE_SIZE 64 // cells per side of a tile, a row of a tile is 8 bytes
+#define CHECKPOINT_TILE_BYTES (CHECKPOINT_TILE_SIZE * CHECKPOINT_TILE_SIZE / 8)
+
+// the encodings of the tiles
+#define CHECKPOINT_EMPTY 0u // no alive cells, no data
+#define CHECKPOINT_BITS 1u // CHECKPOINT_TILE_BYTES bytes, bit x % 8 of byte y * 8 + x / 8 is the cell (x, y) of the tile
+#define CHECKPOINT_RLE 2u // the same bytes as runs of (length 1..255, byte)
+
+// the file: the header, the index of the tiles by rows of tiles, the data of the tiles - all little-endian
+// the index gives the place of every tile, so that a reader mapping the file decodes only the tiles of the region it needs
+// one bit per cell, so only the boards of the two-state rules are checkpointed
+struct CheckpointHeader {
+    char magic[8]; // "AUTOCKPT"
+    uint32_t version;
+    uint32_t tile_size;
+    int32_t width, height;
+    uint32_t birth, survival, states; // the rule
+    uint32_t tiles_x, tiles_y;
+    uint32_t reserved;
+    uint64_t generation;
+    uint64_t hash; // stateHash() of the board
+};
+
+struct CheckpointTile {
+    uint64_t offset; // from the start of the file
+    uint32_t size;
+    uint32_t encoding;
+};
+
+static_assert(sizeof(CheckpointHeader) == 64 && sizeof(CheckpointTile) == 16, "the checkpoint structures have no padding");
+
+inline void checkpointEncodeTile(const unsigned char* cells, int width, int height, int tx, int ty, std::vector<unsigned char>& data, CheckpointTile& tile) {
+    unsigned char bits[CHECKPOINT_TILE_BYTES] = {0};
+    bool empty = true;
+    
+    int x_begin = tx * CHECKPOINT_TILE_SIZE, y_begin = ty * CHECKPOINT_TILE_SIZE;
+    int x_end = std::min(width, x_begin + CHECKPOINT_TILE_SIZE), y_end = std::min(height, y_begin + CHECKPOINT_TILE_SIZE);
+    
+    for(int y = y_begin; y < y_end; y++) {
+        const unsigned char* row = cells + (size_t)y * width;
+        unsigned char* row_bits = bits + (y - y_begin) * (CHECKPOINT_TILE_SIZE / 8);
+        
+        for(int x = x_begin; x < x_end; x++) if(row[x] > 0) {
+            row_bits[(x - x_begin) >> 3] |= 1 << ((x - x_begin) & 7);
+            empty = false;
+        }
+    }
+    
+    tile.offset = 0;
+    tile.size = 0;
+    tile.encoding = CHECKPOINT_EMPTY;
+    if(empty) return;
+    
+    // the runs, kept only when they are shorter than the bits
+    std::vector<unsigned char> runs;
+    for(int i = 0; i < CHECKPOINT_TILE_BYTES && runs.size() < CHECKPOINT_TILE_BYTES;) {
+        int length = 1;
+        while(i + length < CHECKPOINT_TILE_BYTES && length < 255 && bits[i + length] == bits[i]) length++;
+        
+        runs.push_back((unsigned char)length);
+        runs.push_back(bits[i]);
+        i += length;
+    }
+    
+    tile.offset = data.size();
+    if(runs.size() < CHECKPOINT_TILE_BYTES) {
+        tile.encoding = CHECKPOINT_RLE;
+        data.insert(data.end(), runs.begin(), runs.end());
+    } else {
+        tile.encoding = CHECKPOINT_BITS;
+        data.insert(data.end(), bits, bits + CHECKPOINT_TILE_BYTES);
+    }
+    tile.size = (uint32_t)(data.size() - tile.offset);
+}
+
+// write the board to a temporary file and rename it, so that the last checkpoint stays whole until the new one is complete
+inline bool writeCheckpoint(const std::string& path, const unsigned char* cells, int width, int height, const Rule& rule, unsigned long long generation) {
+    if(rule.states > 2) {
+        std::cerr << "ERROR: CHECKPOINT: ONLY THE TWO-STATE RULES ARE CHECKPOINTED, NOT: " << ruleString(rule) << std::endl;
+        return false;
+    }
+    
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "AUTOCKPT", 8);
+    header.version = CHECKPOINT_VERSION;
+    header.tile_size = CHECKPOINT_TILE_SIZE;
+    header.width = width;
+    header.height = height;
+    header.birth = rule.birth;
+    header.survival = rule.survival;
+    header.states = rule.states;
+    header.tiles_x = (width + CHECKPOINT_TILE_SIZE - 1) / CHECKPOINT_TILE_SIZE;
+    header.tiles_y = (height + CHECKPOINT_TILE_SIZE - 1) / CHECKPOINT_TILE_SIZE;
+    header.generation = generation;
+    header.hash = stateHash(cells, width, height);
+    
+    std::vector<CheckpointTile> tiles((size_t)header.tiles_x * header.tiles_y);
+    std::vector<unsigned char> data;
+    for(uint32_t ty = 0; ty < header.tiles_y; ty++) for(uint32_t tx = 0; tx < header.tiles_x; tx++) {
+        checkpointEncodeTile(cells, width, height, tx, ty, data, tiles[(size_t)ty * header.tiles_x + tx]);
+    }
+    
+    uint64_t data_offset = sizeof(header) + tiles.size() * sizeof(CheckpointTile);
+    for(CheckpointTile& tile : tiles) if(tile.encoding != CHECKPOINT_EMPTY) tile.offset += data_offset;
+    
+    std::string path_temp = path + ".tmp";
+    std::ofstream file(path_temp, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)tiles.data(), tiles.size() * sizeof(CheckpointTile));
+    file.write((const char*)data.data(), data.size());
+    file.close();
+    
+    if(!file || std::rename(path_temp.c_str(), path.c_str()) != 0) {
+        std::cerr << "ERROR: CHECKPOINT: CANNOT WRITE: " << path << std::endl;
+        std::remove(path_temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// a checkpoint mapped into memory, the tiles are decoded only when a region covering them is read
+class CheckpointReader {
+private:
+    void* memory;
+    size_t memory_size;
+    const CheckpointTile* tiles;
+    
+    void fail(const std::string& path, const char* message) {
+        std::cerr << "ERROR: CHECKPOINT: " << message << ": " << path << std::endl;
+        exit(-1);
+    }
+    
+    void decodeTile(const CheckpointTile& tile, unsigned char* bits) const {
+        const unsigned char* data = (const unsigned char*)memory + tile.offset;
+        
+        if(tile.encoding == CHECKPOINT_EMPTY) memset(bits, 0, CHECKPOINT_TILE_BYTES);
+        else if(tile.encoding == CHECKPOINT_BITS) memcpy(bits, data, CHECKPOINT_TILE_BYTES);
+        else {
+            // the runs were checked to fill the tile exactly when the file was opened
+            for(uint32_t i = 0, b = 0; i < tile.size; i += 2) {
+                memset(bits + b, data[i + 1], data[i]);
+                b += data[i];
+            }
+        }
+    }
+    
+    bool tileValid(const CheckpointTile& tile) const {
+        if(tile.encoding == CHECKPOINT_EMPTY) return true;
+        if(tile.offset > memory_size || tile.size > memory_size - tile.offset) return false;
+        if(tile.encoding == CHECKPOINT_BITS) return tile.size == CHECKPOINT_TILE_BYTES;
+        if(tile.encoding != CHECKPOINT_RLE || tile.size % 2 != 0) return false;
+        
+        const unsigned char* data = (const unsigned char*)memory + tile.offset;
+        uint32_t bytes = 0;
+        for(uint32_t i = 0; i < tile.size; i += 2) {
+            if(data[i] == 0) return false;
+            bytes += data[i];
+        }
+        return bytes == CHECKPOINT_TILE_BYTES;
+    }
+
+public:
+    CheckpointHeader header;
+    
+    CheckpointReader(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) fail(path, "CANNOT OPEN");
+        
+        struct stat file_stat;
+        fstat(fd, &file_stat);
+        memory_size = (size_t)file_stat.st_size;
+        if(memory_size < sizeof(CheckpointHeader)) fail(path, "NOT A CHECKPOINT");
+        
+        memory = mmap(NULL, memory_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(memory == MAP_FAILED) fail(path, "CANNOT MAP");
+        
+        memcpy(&header, memory, sizeof(header));
+        if(memcmp(header.magic, "AUTOCKPT", 8) != 0 || header.version != CHECKPOINT_VERSION || header.tile_size != CHECKPOINT_TILE_SIZE) fail(path, "NOT A CHECKPOINT OF THIS VERSION");
+        if(header.width < 1 || header.height < 1 || header.tiles_x != (uint32_t)(header.width + CHECKPOINT_TILE_SIZE - 1) / CHECKPOINT_TILE_SIZE || header.tiles_y != (uint32_t)(header.height + CHECKPOINT_TILE_SIZE - 1) / CHECKPOINT_TILE_SIZE) {
+            fail(path, "WRONG DIMENSIONS");
+        }
+        
+        size_t tiles_num = (size_t)header.tiles_x * header.tiles_y;
+        if((memory_size - sizeof(header)) / sizeof(CheckpointTile) < tiles_num) fail(path, "TRUNCATED INDEX");
+        tiles = (const CheckpointTile*)((const unsigned char*)memory + sizeof(header));
+        
+        for(size_t i = 0; i < tiles_num; i++) if(!tileValid(tiles[i])) fail(path, "CORRUPT TILE");
+    }
+    
+    ~CheckpointReader() {
+        munmap(memory, memory_size);
+    }
+    
+    int width() const {
+        return header.width;
+    }
+    
+    int height() const {
+        return header.height;
+    }
+    
+    Rule rule() const {
+        return Rule(header.birth, header.survival, header.states);
+    }
+    
+    // the cells of the region [x, x + region_width) x [y, y + region_height) of the board, 1 for the alive cells and 0 for the dead ones
+    void readRegion(int x, int y, int region_width, int region_height, unsigned char* cells) const {
+        unsigned char bits[CHECKPOINT_TILE_BYTES];
+        
+        int tx_begin = x / CHECKPOINT_TILE_SIZE, tx_end = (x + region_width - 1) / CHECKPOINT_TILE_SIZE;
+        int ty_begin = y / CHECKPOINT_TILE_SIZE, ty_end = (y + region_height - 1) / CHECKPOINT_TILE_SIZE;
+        
+        for(int ty = ty_begin; ty <= ty_end; ty++) for(int tx = tx_begin; tx <= tx_end; tx++) {
+            decodeTile(tiles[(size_t)ty * header.tiles_x + tx], bits);
+            
+            int x_begin = std::max(x, tx * CHECKPOINT_TILE_SIZE), x_end = std::min(x + region_width, (tx + 1) * CHECKPOINT_TILE_SIZE);
+            int y_begin = std::max(y, ty * CHECKPOINT_TILE_SIZE), y_end = std::min(y + region_height, (ty + 1) * CHECKPOINT_TILE_SIZE);
+            
+            for(int cy = y_begin; cy < y_end; cy++) {
+                const unsigned char* row_bits = bits + (cy - ty * CHECKPOINT_TILE_SIZE) * (CHECKPOINT_TILE_SIZE / 8);
+                unsigned char* row = cells + (size_t)(cy - y) * region_width - x;
+                
+                for(int cx = x_begin; cx < x_end; cx++) {
+                    int bit = cx - tx * CHECKPOINT_TILE_SIZE;
+                    row[cx] = (row_bits[bit >> 3] >> (bit & 7)) & 1;
+                }
+            }
+        }
+    }
+    
+    // the whole board, checked against the hash of the header
+    void read(std::vector<unsigned char>& cells) const {
+        cells.resize((size_t)header.width * header.height);
+        readRegion(0, 0, header.width, header.height, cells.data());
+        
+        if(stateHash(cells.data(), header.width, header.height) != header.hash) {
+            std::cerr << "ERROR: CHECKPOINT: THE BOARD DOES NOT MATCH ITS HASH" << std::endl;
+            exit(-1);
+        }
+    }
+};
+
+// writes the checkpoints on a background thread, the caller only reads the board
+// a checkpoint submitted while the previous one is still being written waits for it, a newer one submitted meanwhile replaces it
+class CheckpointWriter {
+private:
+    struct Snapshot {
+        std::string path;
+        std::vector<unsigned char> cells;
+        int width, height;
+        Rule rule;
+        unsigned long long generation;
+    };
+    
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    Snapshot pending;
+    bool has_pending, writing, stopping;
+    
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        
+        while(true) {
+            condition.wait(lock, [this] { return has_pending || stopping; });
+            if(!has_pending) return;
+            
+            Snapshot snapshot;
+            std::swap(snapshot, pending);
+            has_pending = false;
+            writing = true;
+            
+            lock.unlock();
+            writeCheckpoint(snapshot.path, snapshot.cells.data(), snapshot.width, snapshot.height, snapshot.rule, snapshot.generation);
+            lock.lock();
+            
+            writing = false;
+            condition.notify_all();
+        }
+    }
+
+public:
+    CheckpointWriter() : has_pending(false), writing(false), stopping(false) {
+        thread = std::thread(&CheckpointWriter::run, this);
+    }
+    
+    // the pending checkpoint is written before the thread stops
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+    
+    void submit(const std::string& path, std::vector<unsigned char>&& cells, int width, int height, const Rule& rule, unsigned long long generation) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.path = path;
+        pending.cells = std::move(cells);
+        pending.width = width;
+        pending.height = height;
+        pending.rule = rule;
+        pending.generation = generation;
+        has_pending = true;
+        condition.notify_all();
+    }
+    
+    // block until every submitted checkpoint is on disk
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return !has_pending && !writing; });
+    }
+};
+
+#endif /* checkpoint_h */
@@ -0,0 +1,400 @@
+//
+//  distributed.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef distributed_h
+#define distributed_h
+
+// include the standard libraries
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <new>
+
+// include the POSIX libraries
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "engine.h"
+#include "ensemble.h"
+
+// the board stepped by several worker processes: every worker owns a horizontal strip of rows x width cells, the board is width x (rows * workers_num)
+// and the workers are forked by the coordinator, which starts them together, times the generations and gathers the strips
+struct DistributedConfig {
+    int workers_num;
+    bool tcp; // the halo rows go through TCP sockets on the loopback interface, otherwise through POSIX shared memory
+    int width, rows; // the strip of every worker, the weak scaling keeps it fixed
+    Rule rule;
+    uint64_t seed;
+    float density;
+    unsigned int generations;
+    
+    DistributedConfig() : workers_num(2), tcp(false), width(1024), rows(1024), seed(1), density(0.5f), generations(100) {}
+};
+
+inline void distributedFail(const char* message) {
+    std::cerr << "ERROR: DISTRIBUTED: " << message << ": " << strerror(errno) << std::endl;
+    exit(-1);
+}
+
+inline void writeAll(int fd, const void* data, size_t size) {
+    const char* bytes = (const char*)data;
+    while(size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if(written < 0) {
+            if(errno == EINTR) continue;
+            distributedFail("CANNOT WRITE");
+        }
+        bytes += written;
+        size -= written;
+    }
+}
+
+inline void readAll(int fd, void* data, size_t size) {
+    char* bytes = (char*)data;
+    while(size > 0) {
+        ssize_t read_size = read(fd, bytes, size);
+        if(read_size < 0 && errno == EINTR) continue;
+        if(read_size <= 0) distributedFail("CANNOT READ, THE OTHER PROCESS HAS GONE");
+        bytes += read_size;
+        size -= read_size;
+    }
+}
+
+// the exchange of the boundary rows between the neighbouring strips, the strips wrap around like the board
+// the transport is created by the coordinator before the fork and attached to its worker in the child
+class HaloTransport {
+public:
+    virtual ~HaloTransport() {}
+    
+    virtual void attach(int worker) = 0;
+    
+    // send the first row of the strip to the worker above and the last one to the worker below, receive their last and first rows into the halo rows
+    // returns once the neighbours are at the same generation
+    virtual void exchange(const unsigned char* row_first, const unsigned char* row_last, unsigned char* halo_top, unsigned char* halo_bottom) = 0;
+};
+
+// the boundary rows of all the workers in one shared mapping, written before a barrier of all the workers and read after it
+// the rows of two generations in turn, so that a worker writing the next ones never overwrites the ones a slower neighbour still reads
+class HaloTransportSHM : public HaloTransport {
+private:
+    struct Header {
+        std::atomic<int> arrived;
+        std::atomic<int> sense;
+    };
+    
+    int workers_num, width, worker;
+    size_t memory_size;
+    void* memory;
+    Header* header;
+    unsigned char* rows; // [parity][worker][first, last][width]
+    int parity, local_sense;
+    
+    unsigned char* row(int worker_u, int last) {
+        return rows + (((size_t)parity * workers_num + worker_u) * 2 + last) * width;
+    }
+    
+    // a sense-reversing barrier on the atomics of the mapping, the last worker to arrive releases the others
+    void barrier() {
+        local_sense = 1 - local_sense;
+        if(header->arrived.fetch_add(1) + 1 == workers_num) {
+            header->arrived.store(0);
+            header->sense.store(local_sense);
+        } else {
+            while(header->sense.load() != local_sense) sched_yield();
+        }
+    }
+
+public:
+    HaloTransportSHM(int workers_num_u, int width_u) : workers_num(workers_num_u), width(width_u), worker(0), parity(0), local_sense(0) {
+        std::string name = "/automata-" + std::to_string(getpid());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if(fd < 0) distributedFail("CANNOT CREATE THE SHARED MEMORY");
+        
+        memory_size = sizeof(Header) + (size_t)2 * workers_num * 2 * width;
+        if(ftruncate(fd, memory_size) != 0) distributedFail("CANNOT RESIZE THE SHARED MEMORY");
+        
+        memory = mmap(NULL, memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(memory == MAP_FAILED) distributedFail("CANNOT MAP THE SHARED MEMORY");
+        
+        // the mapping is inherited by the workers, the name is not needed any more
+        close(fd);
+        shm_unlink(name.c_str());
+        
+        header = new(memory) Header;
+        header->arrived.store(0);
+        header->sense.store(0);
+        rows = (unsigned char*)memory + sizeof(Header);
+    }
+    
+    ~HaloTransportSHM() {
+        munmap(memory, memory_size);
+    }
+    
+    void attach(int worker_u) {
+        worker = worker_u;
+    }
+    
+    void exchange(const unsigned char* row_first, const unsigned char* row_last, unsigned char* halo_top, unsigned char* halo_bottom) {
+        memcpy(row(worker, 0), row_first, width);
+        memcpy(row(worker, 1), row_last, width);
+        
+        barrier();
+        
+        memcpy(halo_top, row((worker + workers_num - 1) % workers_num, 1), width);
+        memcpy(halo_bottom, row((worker + 1) % workers_num, 0), width);
+        parity = 1 - parity;
+    }
+};
+
+// a TCP connection to each neighbour, a stand-in for the interconnect of a cluster
+// every worker listens on a loopback port opened by the coordinator, connects to the worker below and accepts the worker above
+class HaloTransportTCP : public HaloTransport {
+private:
+    int workers_num, width;
+    std::vector<int> listeners;
+    std::vector<int> ports;
+    int socket_up, socket_down;
+    
+    struct Transfer {
+        int fd;
+        const unsigned char* row_out;
+        unsigned char* row_in;
+        size_t sent, received;
+    };
+    
+    void closeListeners() {
+        for(int listener : listeners) close(listener);
+        listeners.clear();
+    }
+
+public:
+    HaloTransportTCP(int workers_num_u, int width_u) : workers_num(workers_num_u), width(width_u), socket_up(-1), socket_down(-1) {
+        for(int w = 0; w < workers_num; w++) {
+            int listener = socket(AF_INET, SOCK_STREAM, 0);
+            if(listener < 0) distributedFail("CANNOT CREATE A SOCKET");
+            
+            sockaddr_in address;
+            memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = 0; // any free port
+            
+            socklen_t address_size = sizeof(address);
+            if(bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 1) != 0 || getsockname(listener, (sockaddr*)&address, &address_size) != 0) {
+                distributedFail("CANNOT LISTEN ON THE LOOPBACK INTERFACE");
+            }
+            
+            listeners.push_back(listener);
+            ports.push_back(ntohs(address.sin_port));
+        }
+    }
+    
+    ~HaloTransportTCP() {
+        closeListeners();
+        if(socket_up >= 0) close(socket_up);
+        if(socket_down >= 0) close(socket_down);
+    }
+    
+    // the connections are made before the accepts, the listening sockets queue them until then
+    void attach(int worker) {
+        socket_down = socket(AF_INET, SOCK_STREAM, 0);
+        
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(ports[(worker + 1) % workers_num]);
+        if(connect(socket_down, (sockaddr*)&address, sizeof(address)) != 0) distributedFail("CANNOT CONNECT TO THE NEXT WORKER");
+        
+        socket_up = accept(listeners[worker], NULL, NULL);
+        if(socket_up < 0) distributedFail("CANNOT ACCEPT THE PREVIOUS WORKER");
+        
+        closeListeners();
+        
+        int flag = 1;
+        setsockopt(socket_up, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+        setsockopt(socket_down, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+    
+    // both the rows are sent and received at once, so that two neighbours sending to each other never wait on full socket buffers
+    void exchange(const unsigned char* row_first, const unsigned char* row_last, unsigned char* halo_top, unsigned char* halo_bottom) {
+        Transfer transfers[2] = {{socket_up, row_first, halo_top, 0, 0}, {socket_down, row_last, halo_bottom, 0, 0}};
+        size_t row_size = width;
+        
+        while(true) {
+            pollfd fds[2];
+            bool done = true;
+            for(int i = 0; i < 2; i++) {
+                fds[i].fd = transfers[i].fd;
+                fds[i].events = (transfers[i].sent < row_size ? POLLOUT : 0) | (transfers[i].received < row_size ? POLLIN : 0);
+                fds[i].revents = 0;
+                if(fds[i].events) done = false;
+            }
+            if(done) break;
+            
+            if(poll(fds, 2, -1) < 0) {
+                if(errno == EINTR) continue;
+                distributedFail("CANNOT POLL THE SOCKETS");
+            }
+            
+            for(int i = 0; i < 2; i++) {
+                Transfer& transfer = transfers[i];
+                
+                if(fds[i].revents & POLLOUT) {
+                    ssize_t sent = send(transfer.fd, transfer.row_out + transfer.sent, row_size - transfer.sent, MSG_DONTWAIT);
+                    if(sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) distributedFail("CANNOT SEND THE HALO ROW");
+                    if(sent > 0) transfer.sent += sent;
+                }
+                
+                if(fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                    ssize_t received = recv(transfer.fd, transfer.row_in + transfer.received, row_size - transfer.received, MSG_DONTWAIT);
+                    if(received == 0) distributedFail("THE NEIGHBOUR HAS GONE");
+                    if(received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) distributedFail("CANNOT RECEIVE THE HALO ROW");
+                    if(received > 0) transfer.received += received;
+                }
+            }
+        }
+    }
+};
+
+// one generation of the rows [1, rows] of a strip with a halo row above and below, the columns wrap around
+inline void stepStrip(const unsigned char* cells_in, unsigned char* cells_out, int width, int rows, const Rule& rule) {
+    for(int y = 1; y <= rows; y++) {
+        const unsigned char* row_up = cells_in + (size_t)(y - 1) * width;
+        const unsigned char* row = cells_in + (size_t)y * width;
+        const unsigned char* row_down = cells_in + (size_t)(y + 1) * width;
+        unsigned char* row_out = cells_out + (size_t)y * width;
+        
+        for(int x = 0; x < width; x++) {
+            int x_left = (x == 0) ? width - 1 : x - 1;
+            int x_right = (x == width - 1) ? 0 : x + 1;
+            
+            int counter = (row_up[x_left] > 0) + (row_up[x] > 0) + (row_up[x_right] > 0)
+                        + (row[x_left] > 0) + (row[x_right] > 0)
+                        + (row_down[x_left] > 0) + (row_down[x] > 0) + (row_down[x_right] > 0);
+            
+            unsigned char alive = row[x] > 0;
+            
+            row_out[x] = ruleNext(rule.birth, rule.survival, alive, counter) ? (alive ? COLOR_MAX : COLOR_MID) : 0;
+        }
+    }
+}
+
+// the worker: generate its rows of the soup, wait for the start, step and send the strip back over the control socket
+inline void runDistributedWorker(const DistributedConfig& config, int worker, HaloTransport& transport, int control) {
+    transport.attach(worker);
+    
+    int width = config.width, rows = config.rows;
+    std::vector<unsigned char> cells_in((size_t)(rows + 2) * width), cells_out((size_t)(rows + 2) * width);
+    
+    // the same cells as in the soup of the whole board, the coordinator never holds the initial board
+    ensembleSoup(&cells_in[width], width, rows, config.seed, config.density, (uint64_t)worker * rows * width);
+    
+    char message = 1;
+    writeAll(control, &message, 1);
+    
+    uint32_t generations;
+    readAll(control, &generations, sizeof(generations));
+    
+    for(uint32_t g = 0; g < generations; g++) {
+        transport.exchange(&cells_in[width], &cells_in[(size_t)rows * width], &cells_in[0], &cells_in[(size_t)(rows + 1) * width]);
+        stepStrip(cells_in.data(), cells_out.data(), width, rows, config.rule);
+        cells_in.swap(cells_out);
+    }
+    
+    writeAll(control, &message, 1);
+    writeAll(control, &cells_in[width], (size_t)rows * width);
+}
+
+// fork the workers, step them together and gather the board into cells, returns the time of the generations
+// the start of the workers and the gathering are not timed
+inline double runDistributed(const DistributedConfig& config, std::vector<unsigned char>& cells) {
+    requireTwoStates(config.rule, "distributed");
+    
+    int workers_num = config.workers_num;
+    if(workers_num < 1 || config.rows < 1 || config.width < 1) {
+        std::cerr << "ERROR: DISTRIBUTED: WRONG NUMBER OF WORKERS OR SIZE OF STRIPS" << std::endl;
+        exit(-1);
+    }
+    
+    HaloTransport* transport;
+    if(config.tcp) transport = new HaloTransportTCP(workers_num, config.width);
+    else transport = new HaloTransportSHM(workers_num, config.width);
+    
+    std::vector<int> controls;
+    std::vector<pid_t> pids;
+    
+    std::cout.flush();
+    std::cerr.flush();
+    
+    for(int w = 0; w < workers_num; w++) {
+        int fds[2];
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) distributedFail("CANNOT CREATE THE CONTROL SOCKETS");
+        
+        pid_t pid = fork();
+        if(pid < 0) distributedFail("CANNOT START A WORKER");
+        
+        if(pid == 0) {
+            close(fds[0]);
+            for(int control : controls) close(control);
+            
+            runDistributedWorker(config, w, *transport, fds[1]);
+            _exit(0); // without the destructors and the buffers of the coordinator
+        }
+        
+        close(fds[1]);
+        controls.push_back(fds[0]);
+        pids.push_back(pid);
+    }
+    
+    // the generation barrier of the start: all the workers are connected and have their rows
+    
+    char message;
+    for(int control : controls) readAll(control, &message, 1);
+    
+    auto start_time = std::chrono::steady_clock::now();
+    
+    uint32_t generations = config.generations;
+    for(int control : controls) writeAll(control, &generations, sizeof(generations));
+    for(int control : controls) readAll(control, &message, 1);
+    
+    std::chrono::duration<double> run_time = std::chrono::steady_clock::now() - start_time;
+    
+    size_t strip_size = (size_t)config.rows * config.width;
+    cells.resize(strip_size * workers_num);
+    for(int w = 0; w < workers_num; w++) {
+        readAll(controls[w], &cells[strip_size * w], strip_size);
+        close(controls[w]);
+    }
+    
+    for(pid_t pid : pids) {
+        int status;
+        if(waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "ERROR: DISTRIBUTED: A WORKER FAILED" << std::endl;
+            exit(-1);
+        }
+    }
+    
+    delete transport;
+    return run_time.count();
+}
+
+#endif /* distributed_h */
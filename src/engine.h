@@ -0,0 +1,199 @@
+//
+//  engine.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef engine_h
+#define engine_h
+
+// include the standard libraries
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include "rule.h"
+
+// cell values, the same as the ones written by the iterate kernel
+#define COLOR_MAX 255
+#define COLOR_MID 128
+
+// the alive cells of a board as horizontal runs, streamed by the pattern readers so that a backend can fill its own layout without a byte per cell
+class CellRuns {
+public:
+    virtual ~CellRuns() {}
+    
+    // call emit(x, y, length) for every run of alive cells of the board, in any order
+    virtual void forEachRun(const std::function<void(int, int, int)>& emit) = 0;
+};
+
+// common interface of the simulation backends - one byte per cell on the host side, non-zero cells are alive
+class Engine {
+public:
+    int width, height;
+    unsigned long long generation;
+    Rule rule;
+    
+    Engine() : width(0), height(0), generation(0) {}
+    virtual ~Engine() {}
+    
+    virtual const char* name() const = 0;
+    
+    // bytes of state read and written per cell and generation by the main passes over the board, a model for the bandwidth estimates of the benchmarks
+    // one byte read and one written by default
+    virtual double bytesPerCell() const {
+        return 2.0;
+    }
+    
+    // Life (B3/S23) by default, the backends pick the kernel specialized for the rule
+    virtual void setRule(const Rule& rule_u) {
+        rule = rule_u;
+    }
+    
+    // load the state of a board of size width_u x height_u
+    virtual void load(const unsigned char* cells, int width_u, int height_u) = 0;
+    
+    // load a board of size width_u x height_u from its runs of alive cells
+    // through a board of one byte per cell by default, the backends with another layout write the runs into it directly
+    virtual void loadRuns(CellRuns& runs, int width_u, int height_u) {
+        std::vector<unsigned char> cells((size_t)width_u * height_u, 0);
+        runs.forEachRun([&cells, width_u](int x, int y, int length) {
+            memset(&cells[(size_t)y * width_u + x], 1, length);
+        });
+        load(cells.data(), width_u, height_u);
+    }
+    
+    // advance the board by the given number of generations
+    virtual void step(unsigned int generations = 1) = 0;
+    
+    // read back the state: 0 for dead cells, COLOR_MID for newborn cells and COLOR_MAX for the surviving ones
+    virtual void read(unsigned char* cells) = 0;
+};
+
+// the backends storing one bit or one alive flag per cell only run the two-state rules
+inline void requireTwoStates(const Rule& rule, const char* engine_name) {
+    if(rule.states > 2) {
+        std::cerr << "ERROR: ENGINE: " << engine_name << " RUNS ONLY TWO-STATE RULES, USE cpu FOR: " << ruleString(rule) << std::endl;
+        exit(-1);
+    }
+}
+
+// FNV-1a hash of the alive cells, used to compare the final states of the backends
+inline uint64_t stateHash(const unsigned char* cells, int width, int height) {
+    uint64_t hash = 14695981039346656037ULL;
+    
+    for(size_t i = 0; i < (size_t)width * height; i++) {
+        hash ^= cells[i] > 0 ? 1 : 0;
+        hash *= 1099511628211ULL;
+    }
+    
+    return hash;
+}
+
+inline size_t statePopulation(const unsigned char* cells, int width, int height) {
+    size_t population = 0;
+    for(size_t i = 0; i < (size_t)width * height; i++) if(cells[i] > 0) population++;
+    return population;
+}
+
+// splits the rows [0, rows_num) into horizontal strips and processes each strip on its own thread
+// the threads are created once with the engine and sleep between the calls, the calling thread processes the first strip
+class StripPool {
+private:
+    std::vector<std::thread> threads;
+    
+    std::mutex mutex;
+    std::condition_variable start_cv, done_cv;
+    const std::function<void(int, int)>* process_rows; // the call in progress, guarded by mutex
+    int rows_num;
+    unsigned int strips_num;
+    unsigned long long round; // calls started
+    unsigned int threads_busy; // threads yet to finish the current call
+    bool stopping;
+    
+    void work(unsigned int index) {
+        unsigned long long round_done = 0;
+        
+        while(true) {
+            const std::function<void(int, int)>* process;
+            int rows;
+            unsigned int strips;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start_cv.wait(lock, [this, round_done] { return round != round_done || stopping; });
+                if(stopping) return;
+                
+                round_done = round;
+                process = process_rows;
+                rows = rows_num;
+                strips = strips_num;
+            }
+            
+            if(index < strips) (*process)((int)((size_t)rows * index / strips), (int)((size_t)rows * (index + 1) / strips));
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            if(--threads_busy == 0) done_cv.notify_one();
+        }
+    }
+
+public:
+    StripPool(unsigned int threads_num) : process_rows(nullptr), rows_num(0), strips_num(0), round(0), threads_busy(0), stopping(false) {
+        for(unsigned int i = 1; i < threads_num; i++) threads.push_back(std::thread(&StripPool::work, this, i));
+    }
+    
+    StripPool(const StripPool&) = delete;
+    StripPool& operator=(const StripPool&) = delete;
+    
+    ~StripPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        start_cv.notify_all();
+        
+        for(std::thread& thread : threads) thread.join();
+    }
+    
+    unsigned int size() const {
+        return (unsigned int)threads.size() + 1;
+    }
+    
+    void run(int rows_num_u, const std::function<void(int, int)>& process_rows_u) {
+        unsigned int strips = size() < (unsigned int)rows_num_u ? size() : (unsigned int)rows_num_u;
+        if(strips <= 1) {
+            process_rows_u(0, rows_num_u);
+            return;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            process_rows = &process_rows_u;
+            rows_num = rows_num_u;
+            strips_num = strips;
+            threads_busy = (unsigned int)threads.size();
+            round++;
+        }
+        start_cv.notify_all();
+        
+        process_rows_u(0, (int)(rows_num_u / strips));
+        
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this] { return threads_busy == 0; });
+    }
+};
+
+inline unsigned int defaultThreadsNum(unsigned int threads_num) {
+    if(threads_num == 0) threads_num = std::thread::hardware_concurrency();
+    return threads_num > 0 ? threads_num : 1;
+}
+
+#endif /* engine_h */
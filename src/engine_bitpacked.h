@@ -0,0 +1,245 @@
+//
+//  engine_bitpacked.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef engine_bitpacked_h
+#define engine_bitpacked_h
+
+// include the standard libraries
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "engine.h"
+
+#define BITPACKED_TILE_ROWS 64 // the change tracking tiles are 64x64 cells, one word wide
+
+// CPU backend storing one bit per cell, 64 cells per word - cell x of a row is bit x % 64 of word x / 64
+// tiles are skipped when neither they nor their neighbours changed in the last generation, the output buffer then already holds the same state
+class EngineBitPacked : public Engine {
+private:
+    typedef void (EngineBitPacked::*BandsKernel)(int, int);
+    
+    template<uint32_t BIRTH, uint32_t SURVIVAL>
+    struct BandsSpecialization {
+        typedef BandsKernel Kernel;
+        static Kernel kernel() { return &EngineBitPacked::iterateBands<BIRTH, SURVIVAL>; }
+    };
+    
+    std::vector<uint64_t> cells_in, cells_out;
+    int words_num; // words per row
+    uint64_t last_mask; // valid bits of the last word in a row
+    StripPool strips;
+    BandsKernel bands_kernel;
+    
+    int tiles_y; // the tiles are words_num wide
+    std::vector<unsigned char> tiles_changed, tiles_changed_next, tiles_active;
+    
+    inline uint64_t cellBit(const uint64_t* row, int x) const {
+        return (row[x >> 6] >> (x & 63)) & 1ULL;
+    }
+    
+    // the neighbours to the west and to the east of the 64 cells of the word i, the row wraps around like in the kernel
+    inline void shiftWord(const uint64_t* row, int i, uint64_t& west, uint64_t& east) const {
+        uint64_t word = row[i];
+        
+        uint64_t carry_west = (i == 0) ? cellBit(row, width - 1) : (row[i - 1] >> 63);
+        west = (word << 1) | carry_west;
+        
+        if(i == words_num - 1) east = (word >> 1) | (cellBit(row, 0) << ((width - 1) & 63));
+        else east = (word >> 1) | (row[i + 1] << 63);
+    }
+    
+    // cells with exactly n neighbours live if bit n of the rule mask of their state is set, the loop folds away for the specialized rules
+    static inline uint64_t applyRule(uint64_t r0, uint64_t r1, uint64_t r2, uint64_t r3, uint64_t alive, uint32_t birth, uint32_t survival) {
+        uint64_t next = 0;
+        
+        for(int n = 0; n < 9; n++) {
+            uint64_t equal = ((n & 1) ? r0 : ~r0) & ((n & 2) ? r1 : ~r1) & ((n & 4) ? r2 : ~r2) & ((n & 8) ? r3 : ~r3);
+            uint64_t lives = (alive & (0 - (uint64_t)((survival >> n) & 1u))) | (~alive & (0 - (uint64_t)((birth >> n) & 1u)));
+            next |= equal & lives;
+        }
+        
+        return next;
+    }
+    
+    // the next state of the 64 cells of the word i, birth and survival are read only by the RULE_DYNAMIC instantiation
+    template<uint32_t BIRTH, uint32_t SURVIVAL>
+    inline uint64_t nextWord(const uint64_t* row_up, const uint64_t* row, const uint64_t* row_down, int i, uint32_t birth, uint32_t survival) const {
+        uint64_t uw, ue, mw, me, dw, de;
+        shiftWord(row_up, i, uw, ue);
+        shiftWord(row, i, mw, me);
+        shiftWord(row_down, i, dw, de);
+        
+        uint64_t uc = row_up[i], alive = row[i], dc = row_down[i];
+        
+        // bit-sliced sums of the three rows: up and down count 0..3, the middle one 0..2
+        uint64_t u0 = uw ^ uc ^ ue;
+        uint64_t u1 = (uw & uc) | (ue & (uw ^ uc));
+        uint64_t d0 = dw ^ dc ^ de;
+        uint64_t d1 = (dw & dc) | (de & (dw ^ dc));
+        uint64_t m0 = mw ^ me;
+        uint64_t m1 = mw & me;
+        
+        // full adders: up + down
+        uint64_t s0 = u0 ^ d0;
+        uint64_t c0 = u0 & d0;
+        uint64_t s1 = u1 ^ d1 ^ c0;
+        uint64_t s2 = (u1 & d1) | (c0 & (u1 ^ d1));
+        
+        // full adders: + middle, the counter is r0 + 2 * r1 + 4 * r2 + 8 * r3
+        uint64_t r0 = s0 ^ m0;
+        uint64_t k0 = s0 & m0;
+        uint64_t r1 = s1 ^ m1 ^ k0;
+        uint64_t k1 = (s1 & m1) | (k0 & (s1 ^ m1));
+        uint64_t r2 = s2 ^ k1;
+        uint64_t r3 = s2 & k1;
+        
+        uint64_t next;
+        
+        // Life: alive if the counter is 3, or 2 for the alive cells; the other specialized rules pass their masks as constants, so the loop of applyRule folds
+        if(ruleIsLife(BIRTH, SURVIVAL)) next = r1 & ~r2 & ~r3 & (r0 | alive);
+        else next = applyRule(r0, r1, r2, r3, alive, BIRTH == RULE_DYNAMIC ? birth : BIRTH, SURVIVAL == RULE_DYNAMIC ? survival : SURVIVAL);
+        
+        if(i == words_num - 1) next &= last_mask;
+        return next;
+    }
+    
+    template<uint32_t BIRTH, uint32_t SURVIVAL>
+    void iterateBands(int band_begin, int band_end) {
+        std::vector<uint64_t> changed(words_num);
+        
+        for(int ty = band_begin; ty < band_end; ty++) {
+            int y_begin = ty * BITPACKED_TILE_ROWS;
+            int y_end = std::min(height, y_begin + BITPACKED_TILE_ROWS);
+            const unsigned char* band_active = &tiles_active[(size_t)ty * words_num];
+            
+            std::fill(changed.begin(), changed.end(), 0);
+            
+            for(int y = y_begin; y < y_end; y++) {
+                const uint64_t* row_up = &cells_in[(size_t)((y + height - 1) % height) * words_num];
+                const uint64_t* row = &cells_in[(size_t)y * words_num];
+                const uint64_t* row_down = &cells_in[(size_t)((y + 1) % height) * words_num];
+                uint64_t* row_out = &cells_out[(size_t)y * words_num];
+                
+                for(int i = 0; i < words_num; i++) {
+                    if(!band_active[i]) continue;
+                    
+                    uint64_t next = nextWord<BIRTH, SURVIVAL>(row_up, row, row_down, i, rule.birth, rule.survival);
+                    row_out[i] = next;
+                    changed[i] |= next ^ row[i];
+                }
+            }
+            
+            for(int i = 0; i < words_num; i++) tiles_changed_next[(size_t)ty * words_num + i] = changed[i] != 0;
+        }
+    }
+    
+    void findActiveTiles() {
+        for(int ty = 0; ty < tiles_y; ty++) for(int tx = 0; tx < words_num; tx++) {
+            unsigned char active = 0;
+            for(int j = -1; j <= 1; j++) for(int i = -1; i <= 1; i++) {
+                active |= tiles_changed[(size_t)((ty + j + tiles_y) % tiles_y) * words_num + (tx + i + words_num) % words_num];
+            }
+            tiles_active[(size_t)ty * words_num + tx] = active;
+        }
+    }
+    
+    void iterate() {
+        findActiveTiles();
+        
+        // the strips are whole bands of tiles, so that every thread writes the change flags of its own tiles
+        strips.run(tiles_y, [this](int band_begin, int band_end) { (this->*bands_kernel)(band_begin, band_end); });
+        
+        cells_in.swap(cells_out);
+        tiles_changed.swap(tiles_changed_next);
+        generation++;
+    }
+
+    // an empty board of size width_u x height_u
+    void resize(int width_u, int height_u) {
+        width = width_u;
+        height = height_u;
+        generation = 0;
+        
+        words_num = (width + 63) / 64;
+        last_mask = (width & 63) ? ((1ULL << (width & 63)) - 1) : ~0ULL;
+        
+        cells_in.assign((size_t)words_num * height, 0);
+        cells_out.assign((size_t)words_num * height, 0);
+        
+        tiles_y = (height + BITPACKED_TILE_ROWS - 1) / BITPACKED_TILE_ROWS;
+        tiles_changed.assign((size_t)words_num * tiles_y, 1);
+        tiles_changed_next.assign((size_t)words_num * tiles_y, 0);
+        tiles_active.assign((size_t)words_num * tiles_y, 1);
+    }
+
+public:
+    EngineBitPacked(unsigned int threads_num_u = 0) : strips(defaultThreadsNum(threads_num_u)) {
+        bands_kernel = specializeRule<BandsSpecialization>(rule);
+    }
+    
+    const char* name() const {
+        return "bitpacked";
+    }
+    
+    // one bit read and one written
+    double bytesPerCell() const {
+        return 0.25;
+    }
+    
+    void setRule(const Rule& rule_u) {
+        requireTwoStates(rule_u, name());
+        rule = rule_u;
+        bands_kernel = specializeRule<BandsSpecialization>(rule);
+        
+        // the change flags were computed under the old rule
+        std::fill(tiles_changed.begin(), tiles_changed.end(), 1);
+    }
+    
+    void load(const unsigned char* cells, int width_u, int height_u) {
+        resize(width_u, height_u);
+        
+        for(int y = 0; y < height; y++) for(int x = 0; x < width; x++) {
+            if(cells[(size_t)y * width + x] > 0) cells_in[(size_t)y * words_num + (x >> 6)] |= 1ULL << (x & 63);
+        }
+    }
+    
+    // the runs are set a word at a time, the board never exists as bytes
+    void loadRuns(CellRuns& runs, int width_u, int height_u) {
+        resize(width_u, height_u);
+        
+        runs.forEachRun([this](int x, int y, int length) {
+            uint64_t* row = &cells_in[(size_t)y * words_num];
+            
+            for(int x_end = x + length; x < x_end;) {
+                int bits = std::min(64 - (x & 63), x_end - x);
+                row[x >> 6] |= (bits == 64 ? ~0ULL : ((1ULL << bits) - 1)) << (x & 63);
+                x += bits;
+            }
+        });
+    }
+    
+    void step(unsigned int generations = 1) {
+        for(unsigned int i = 0; i < generations; i++) iterate();
+    }
+    
+    void read(unsigned char* cells) {
+        // the previous generation is still in cells_out, use it to tell the newborn cells from the surviving ones
+        for(int y = 0; y < height; y++) for(int x = 0; x < width; x++) {
+            size_t word = (size_t)y * words_num + (x >> 6);
+            uint64_t bit = 1ULL << (x & 63);
+            
+            unsigned char col = 0;
+            if(cells_in[word] & bit) col = (generation == 0 || (cells_out[word] & bit)) ? COLOR_MAX : COLOR_MID;
+            
+            cells[(size_t)y * width + x] = col;
+        }
+    }
+};
+
+#endif /* engine_bitpacked_h */
@@ -0,0 +1,159 @@
+//
+//  engine_cpu.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef engine_cpu_h
+#define engine_cpu_h
+
+// include the standard libraries
+#include <vector>
+#include <algorithm>
+
+#include "engine.h"
+
+// multi-core CPU implementation of the iterate kernel, one byte per cell
+class EngineCPU : public Engine {
+private:
+    typedef void (EngineCPU::*RowsKernel)(int, int);
+    
+    template<uint32_t BIRTH, uint32_t SURVIVAL>
+    struct RowsSpecialization {
+        typedef RowsKernel Kernel;
+        static Kernel kernel() { return &EngineCPU::iterateRows<BIRTH, SURVIVAL>; }
+    };
+    
+    std::vector<unsigned char> cells_in, cells_out;
+    StripPool strips;
+    RowsKernel rows_kernel;
+    
+    // Generations rules: the state of every cell and the transitions of the rule, see ruleTransitions()
+    std::vector<unsigned char> states_in, states_out;
+    std::vector<unsigned char> transitions;
+    
+    template<uint32_t BIRTH, uint32_t SURVIVAL>
+    void iterateRows(int y_begin, int y_end) {
+        // the rule masks are compile-time constants unless the rule is not one of the specialized ones
+        const uint32_t birth = (BIRTH == RULE_DYNAMIC) ? rule.birth : BIRTH;
+        const uint32_t survival = (SURVIVAL == RULE_DYNAMIC) ? rule.survival : SURVIVAL;
+        
+        for(int y = y_begin; y < y_end; y++) {
+            // wrap the board around like the (y + j + height) % height in the kernel
+            const unsigned char* row_up = &cells_in[(size_t)((y + height - 1) % height) * width];
+            const unsigned char* row = &cells_in[(size_t)y * width];
+            const unsigned char* row_down = &cells_in[(size_t)((y + 1) % height) * width];
+            unsigned char* row_out = &cells_out[(size_t)y * width];
+            
+            for(int x = 0; x < width; x++) {
+                int x_left = (x == 0) ? width - 1 : x - 1;
+                int x_right = (x == width - 1) ? 0 : x + 1;
+                
+                int counter = (row_up[x_left] > 0) + (row_up[x] > 0) + (row_up[x_right] > 0)
+                            + (row[x_left] > 0) + (row[x_right] > 0)
+                            + (row_down[x_left] > 0) + (row_down[x] > 0) + (row_down[x_right] > 0);
+                
+                unsigned char alive = row[x] > 0;
+                
+                row_out[x] = ruleNext(birth, survival, alive, counter) ? (alive ? COLOR_MAX : COLOR_MID) : 0;
+            }
+        }
+    }
+    
+    void iterateRowsGenerations(int y_begin, int y_end) {
+        const unsigned char* transitions_data = transitions.data();
+        
+        for(int y = y_begin; y < y_end; y++) {
+            const unsigned char* row_up = &states_in[(size_t)((y + height - 1) % height) * width];
+            const unsigned char* row = &states_in[(size_t)y * width];
+            const unsigned char* row_down = &states_in[(size_t)((y + 1) % height) * width];
+            unsigned char* row_out = &states_out[(size_t)y * width];
+            unsigned char* row_cells_out = &cells_out[(size_t)y * width];
+            
+            for(int x = 0; x < width; x++) {
+                int x_left = (x == 0) ? width - 1 : x - 1;
+                int x_right = (x == width - 1) ? 0 : x + 1;
+                
+                // only the alive cells count, not the dying ones
+                int counter = (row_up[x_left] == 1) + (row_up[x] == 1) + (row_up[x_right] == 1)
+                            + (row[x_left] == 1) + (row[x_right] == 1)
+                            + (row_down[x_left] == 1) + (row_down[x] == 1) + (row_down[x_right] == 1);
+                
+                unsigned char next = transitions_data[row[x] * 9 + counter];
+                
+                row_out[x] = next;
+                row_cells_out[x] = next == 1 ? (row[x] == 1 ? COLOR_MAX : COLOR_MID) : 0;
+            }
+        }
+    }
+    
+    void iterate() {
+        // split the board into horizontal strips, one per thread
+        strips.run(height, [this](int y_begin, int y_end) { (this->*rows_kernel)(y_begin, y_end); });
+        
+        cells_in.swap(cells_out);
+        if(rule.states > 2) states_in.swap(states_out);
+        generation++;
+    }
+    
+    void selectKernel() {
+        if(rule.states > 2) rows_kernel = &EngineCPU::iterateRowsGenerations;
+        else rows_kernel = specializeRule<RowsSpecialization>(rule);
+    }
+
+public:
+    EngineCPU(unsigned int threads_num_u = 0) : strips(defaultThreadsNum(threads_num_u)) {
+        selectKernel();
+    }
+    
+    const char* name() const {
+        return "cpu";
+    }
+    
+    void setRule(const Rule& rule_u) {
+        // the states of a two-state board are its alive cells
+        if(rule_u.states > 2 && rule.states <= 2) {
+            states_in.resize(cells_in.size());
+            states_out.assign(cells_in.size(), 0);
+            for(size_t i = 0; i < cells_in.size(); i++) states_in[i] = cells_in[i] > 0;
+        }
+        
+        rule = rule_u;
+        transitions = ruleTransitions(rule);
+        selectKernel();
+    }
+    
+    void load(const unsigned char* cells, int width_u, int height_u) {
+        width = width_u;
+        height = height_u;
+        generation = 0;
+        
+        cells_in.resize((size_t)width * height);
+        cells_out.resize((size_t)width * height);
+        for(size_t i = 0; i < cells_in.size(); i++) cells_in[i] = cells[i] > 0 ? COLOR_MAX : 0;
+        
+        if(rule.states > 2) {
+            states_in.resize(cells_in.size());
+            states_out.assign(cells_in.size(), 0);
+            for(size_t i = 0; i < cells_in.size(); i++) states_in[i] = cells[i] > 0;
+        }
+    }
+    
+    void step(unsigned int generations = 1) {
+        for(unsigned int i = 0; i < generations; i++) iterate();
+    }
+    
+    void read(unsigned char* cells) {
+        std::copy(cells_in.begin(), cells_in.end(), cells);
+    }
+    
+    // the state of every cell: 0 dead, 1 alive, 2 and more dying (Generations rules only)
+    void readStates(unsigned char* states) {
+        if(rule.states > 2) std::copy(states_in.begin(), states_in.end(), states);
+        else for(size_t i = 0; i < cells_in.size(); i++) states[i] = cells_in[i] > 0;
+    }
+};
+
+#endif /* engine_cpu_h */
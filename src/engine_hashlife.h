@@ -0,0 +1,672 @@
+//
+//  engine_hashlife.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef engine_hashlife_h
+#define engine_hashlife_h
+
+// include the standard libraries
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
+#include <iostream>
+
+#include "engine.h"
+
+#define HASHLIFE_NODES_MAX (1 << 23) // garbage collect once the node cache grows past this size, also in the middle of a step
+#define HASHLIFE_NONE 0xFFFFFFFFu
+#define HASHLIFE_HASH_PRIME ((1ULL << 61) - 1) // the hash of the quadtree is a polynomial in the coordinates of the alive cells modulo this prime
+#define HASHLIFE_HASH_X 0x1B873593A5C3E72FULL % HASHLIFE_HASH_PRIME
+#define HASHLIFE_HASH_Y 0x0CC9E2D51F2A8B3DULL % HASHLIFE_HASH_PRIME
+#define HASHLIFE_LOAD_LEAVES (1 << 16) // the leaves of the runs gathered before they are inserted into the quadtree
+#define HASHLIFE_LEVEL_MAX 30 // the sides of the board are ints, a quadtree can cover at most 2^30 x 2^30 cells
+
+// a node of a quadtree given from outside, e.g. by a Macrocell file: node 0 is empty, the others refer to the nodes before them
+// a leaf covers 8x8 cells (level 3), cell (x, y) of the leaf is bit y * 8 + x
+struct QuadtreeNode {
+    uint32_t level;
+    uint32_t nw, ne, sw, se; // the children above level 3
+    uint64_t leaf; // the cells at level 3
+};
+
+// HashLife: the board is a quadtree of canonical (hash-consed) nodes, and the RESULT of every node - its centre advanced 2^step_log generations - is memoized
+// on a board with power-of-two sides the torus of the other backends is kept by stepping a periodic tiling of the board, otherwise the board is placed on an infinite empty plane
+class EngineHashLife : public Engine {
+private:
+    struct Node {
+        uint32_t nw, ne, sw, se; // children, a node at level k covers 2^k x 2^k cells
+        uint32_t result; // memoized RESULT for the current step_log
+        uint32_t level;
+        uint64_t population;
+        bool marked;
+    };
+    
+    struct NodeKey {
+        uint32_t nw, ne, sw, se;
+        
+        bool operator==(const NodeKey& key) const {
+            return nw == key.nw && ne == key.ne && sw == key.sw && se == key.se;
+        }
+    };
+    
+    struct NodeKeyHash {
+        size_t operator()(const NodeKey& key) const {
+            uint64_t hash = key.nw * 0x9E3779B97F4A7C15ULL;
+            hash = (hash ^ key.ne) * 0xC2B2AE3D27D4EB4FULL;
+            hash = (hash ^ key.sw) * 0x165667B19E3779F9ULL;
+            hash = (hash ^ key.se) * 0x9E3779B97F4A7C15ULL;
+            return (size_t)(hash ^ (hash >> 29));
+        }
+    };
+    
+    std::vector<Node> nodes; // nodes 0 and 1 are the dead and the alive cell
+    std::vector<uint32_t> nodes_free;
+    std::unordered_map<NodeKey, uint32_t, NodeKeyHash> nodes_table;
+    std::vector<uint32_t> empty_nodes; // the empty node of every level
+    
+    size_t nodes_max, nodes_limit; // nodes_limit is raised above nodes_max while more than half of the cache is still reachable
+    std::vector<uint32_t> nodes_held; // the nodes the frames of result() still use, kept by the collections in the middle of a step
+    int step_log; // log2 of the generations advanced by the memoized results, -1 if no result is cached
+    
+    bool torus;
+    uint32_t root;
+    long long origin_x, origin_y; // position of the top left corner of the root on the plane
+    
+    uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+        NodeKey key = {nw, ne, sw, se};
+        
+        auto it = nodes_table.find(key);
+        if(it != nodes_table.end()) return it->second;
+        
+        Node node;
+        node.nw = nw;
+        node.ne = ne;
+        node.sw = sw;
+        node.se = se;
+        node.result = HASHLIFE_NONE;
+        node.level = nodes[nw].level + 1;
+        node.population = nodes[nw].population + nodes[ne].population + nodes[sw].population + nodes[se].population;
+        node.marked = false;
+        
+        uint32_t index;
+        if(!nodes_free.empty()) {
+            index = nodes_free.back();
+            nodes_free.pop_back();
+            nodes[index] = node;
+        } else {
+            index = (uint32_t)nodes.size();
+            nodes.push_back(node);
+        }
+        
+        nodes_table[key] = index;
+        return index;
+    }
+    
+    uint32_t emptyNode(uint32_t level) {
+        while(empty_nodes.size() <= level) {
+            uint32_t child = empty_nodes.back();
+            empty_nodes.push_back(join(child, child, child, child));
+        }
+        return empty_nodes[level];
+    }
+    
+    uint32_t centre(uint32_t index) {
+        const Node n = nodes[index];
+        return join(nodes[n.nw].se, nodes[n.ne].sw, nodes[n.sw].ne, nodes[n.se].nw);
+    }
+    
+    // the next generation of the centre 2x2 cells of a 4x4 node
+    uint32_t resultBase(uint32_t index) {
+        int cells[4][4];
+        
+        const Node n = nodes[index];
+        uint32_t quadrants[4] = {n.nw, n.ne, n.sw, n.se};
+        for(int q = 0; q < 4; q++) {
+            const Node& quadrant = nodes[quadrants[q]];
+            int x = (q & 1) * 2, y = (q >> 1) * 2;
+            cells[y][x] = (int)quadrant.nw;
+            cells[y][x + 1] = (int)quadrant.ne;
+            cells[y + 1][x] = (int)quadrant.sw;
+            cells[y + 1][x + 1] = (int)quadrant.se;
+        }
+        
+        uint32_t next[4];
+        for(int y = 1; y < 3; y++) for(int x = 1; x < 3; x++) {
+            int counter = 0;
+            for(int j = -1; j < 2; j++) for(int i = -1; i < 2; i++) if(i != 0 || j != 0) counter += cells[y + j][x + i];
+            
+            next[(y - 1) * 2 + (x - 1)] = ruleNext(rule.birth, rule.survival, (unsigned char)cells[y][x], counter);
+        }
+        
+        return join(next[0], next[1], next[2], next[3]);
+    }
+    
+    // RESULT of a node at level k: its centre at level k - 1 advanced 2^min(step_log, k - 2) generations
+    uint32_t result(uint32_t index) {
+        if(nodes[index].result != HASHLIFE_NONE) return nodes[index].result;
+        
+        // a single large step can build far more nodes than the cache holds, collect before the sub-nodes of this one are built
+        if(nodesNum() > nodes_limit) {
+            nodes_held.push_back(index);
+            collectGarbage();
+            nodes_held.pop_back();
+        }
+        
+        const Node n = nodes[index];
+        uint32_t result_index;
+        
+        if(nodes[index].population == 0) {
+            result_index = emptyNode(n.level - 1);
+        } else if(n.level == 2) {
+            result_index = resultBase(index);
+        } else {
+            const Node nw = nodes[n.nw], ne = nodes[n.ne], sw = nodes[n.sw], se = nodes[n.se];
+            
+            // the node, the 9 overlapping sub-nodes at level k - 1 and the 4 results are held, the deeper frames may collect garbage
+            size_t held = nodes_held.size();
+            nodes_held.insert(nodes_held.end(), {
+                index,
+                n.nw, join(nw.ne, ne.nw, nw.se, ne.sw), n.ne,
+                join(nw.sw, nw.se, sw.nw, sw.ne), join(nw.se, ne.sw, sw.ne, se.nw), join(ne.sw, ne.se, se.nw, se.ne),
+                n.sw, join(sw.ne, se.nw, sw.se, se.sw), n.se
+            });
+            size_t sub = held + 1;
+            
+            // full speed: two rounds of results, 2^(k - 3) generations each, otherwise only the second round advances the board
+            bool full_speed = step_log >= (int)n.level - 2;
+            for(size_t i = sub; i < sub + 9; i++) {
+                uint32_t next = full_speed ? result(nodes_held[i]) : centre(nodes_held[i]);
+                nodes_held[i] = next;
+            }
+            
+            const size_t quadrants[4][4] = {{0, 1, 3, 4}, {1, 2, 4, 5}, {3, 4, 6, 7}, {4, 5, 7, 8}};
+            for(int q = 0; q < 4; q++) {
+                const size_t* quadrant = quadrants[q];
+                uint32_t next = result(join(nodes_held[sub + quadrant[0]], nodes_held[sub + quadrant[1]], nodes_held[sub + quadrant[2]], nodes_held[sub + quadrant[3]]));
+                nodes_held.push_back(next);
+            }
+            
+            size_t results = sub + 9;
+            result_index = join(nodes_held[results], nodes_held[results + 1], nodes_held[results + 2], nodes_held[results + 3]);
+            nodes_held.resize(held);
+        }
+        
+        nodes[index].result = result_index;
+        return result_index;
+    }
+    
+    void setStepLog(int step_log_u) {
+        if(step_log == step_log_u) return;
+        
+        // the result of a node at level k advances 2^min(step_log, k - 2) generations, so the nodes up to the level min + 2 of the two step sizes keep theirs
+        uint32_t level_kept = (step_log < 0) ? 0 : (uint32_t)std::min(step_log, step_log_u) + 2;
+        for(Node& node : nodes) if(node.level > level_kept) node.result = HASHLIFE_NONE;
+        step_log = step_log_u;
+    }
+    
+    uint32_t expand(uint32_t index) {
+        const Node n = nodes[index];
+        uint32_t empty = emptyNode(n.level - 1);
+        
+        origin_x -= 1LL << (n.level - 1);
+        origin_y -= 1LL << (n.level - 1);
+        
+        return join(join(empty, empty, empty, n.nw), join(empty, empty, n.ne, empty), join(empty, n.sw, empty, empty), join(n.se, empty, empty, empty));
+    }
+    
+    // true if all the cells of the node lie in its centre half
+    bool isCentred(uint32_t index) {
+        const Node n = nodes[index];
+        if(n.level < 2) return false;
+        
+        return nodes[nodes[n.nw].se].population == nodes[n.nw].population
+            && nodes[nodes[n.ne].sw].population == nodes[n.ne].population
+            && nodes[nodes[n.sw].ne].population == nodes[n.sw].population
+            && nodes[nodes[n.se].nw].population == nodes[n.se].population;
+    }
+    
+    // advance the board by 2^step_log_u generations
+    void advance(unsigned int step_log_u) {
+        setStepLog((int)step_log_u);
+        
+        uint32_t level = nodes[root].level;
+        
+        if(torus) {
+            // tile the periodic board until the result of the tiling covers 2^step_log_u generations
+            uint32_t tiling = root;
+            uint32_t tiling_level = level;
+            while(tiling_level < level + 1 || (int)tiling_level < (int)step_log_u + 2) {
+                tiling = join(tiling, tiling, tiling, tiling);
+                tiling_level++;
+            }
+            
+            uint32_t next = result(tiling);
+            
+            if(tiling_level == level + 1) {
+                // the result is shifted by half of the board, put the quadrants back in place
+                const Node n = nodes[next];
+                root = join(n.se, n.sw, n.ne, n.nw);
+            } else {
+                // the result starts at a multiple of the board size
+                while(nodes[next].level > level) next = nodes[next].nw;
+                root = next;
+            }
+        } else {
+            // pad the pattern with empty space, so that it cannot leave the result in 2^step_log_u generations
+            while((int)nodes[root].level < (int)step_log_u + 3 || !isCentred(root)) root = expand(root);
+            root = expand(root);
+            
+            uint32_t quarter = nodes[root].level - 2;
+            root = result(root);
+            origin_x += 1LL << quarter;
+            origin_y += 1LL << quarter;
+            
+            // trim the empty border again
+            while(nodes[root].level > level && isCentred(root)) {
+                origin_x += 1LL << (nodes[root].level - 2);
+                origin_y += 1LL << (nodes[root].level - 2);
+                root = centre(root);
+            }
+        }
+        
+        generation += 1ULL << step_log_u;
+        
+        if(nodesNum() > nodes_limit) collectGarbage();
+    }
+    
+    void mark(uint32_t index) {
+        if(nodes[index].marked) return;
+        nodes[index].marked = true;
+        
+        if(nodes[index].level > 0) {
+            mark(nodes[index].nw);
+            mark(nodes[index].ne);
+            mark(nodes[index].sw);
+            mark(nodes[index].se);
+        }
+    }
+    
+    // free every node unreachable from the root and the held nodes, and the results pointing to the freed nodes
+    void collectGarbage() {
+        for(Node& node : nodes) node.marked = false;
+        
+        mark(0);
+        mark(1);
+        mark(root);
+        for(uint32_t empty : empty_nodes) mark(empty);
+        for(uint32_t held : nodes_held) mark(held);
+        
+        nodes_free.clear();
+        for(uint32_t i = 0; i < nodes.size(); i++) {
+            Node& node = nodes[i];
+            
+            if(!node.marked) {
+                if(node.level != HASHLIFE_NONE) {
+                    NodeKey key = {node.nw, node.ne, node.sw, node.se};
+                    nodes_table.erase(key);
+                }
+                node.level = HASHLIFE_NONE; // free slot
+                node.result = HASHLIFE_NONE;
+                nodes_free.push_back(i);
+            } else if(node.result != HASHLIFE_NONE && !nodes[node.result].marked) {
+                node.result = HASHLIFE_NONE;
+            }
+        }
+        
+        // the cap is soft: with more than half of it still reachable, the next collection waits until the cache has doubled
+        nodes_limit = std::max(nodes_max, 2 * nodesNum());
+    }
+    
+    // cell(x, y) is 1 for the alive cells of the board
+    template<typename Cell>
+    uint32_t build(const Cell& cell, uint32_t level, long long x0, long long y0) {
+        if(level == 0) {
+            long long x = x0, y = y0;
+            if(torus) {
+                x %= width;
+                y %= height;
+            } else if(x >= width || y >= height) {
+                return 0;
+            }
+            return cell((int)x, (int)y);
+        }
+        
+        if(!torus && (x0 >= width || y0 >= height)) return emptyNode(level);
+        
+        long long half = 1LL << (level - 1);
+        return join(build(cell, level - 1, x0, y0), build(cell, level - 1, x0 + half, y0),
+                    build(cell, level - 1, x0, y0 + half), build(cell, level - 1, x0 + half, y0 + half));
+    }
+    
+    // the node of the level-3 leaf, or of one of its quadrants
+    uint32_t buildLeaf(uint64_t leaf, uint32_t level, int x0, int y0) {
+        if(level == 0) return (leaf >> (y0 * 8 + x0)) & 1;
+        
+        int half = 1 << (level - 1);
+        return join(buildLeaf(leaf, level - 1, x0, y0), buildLeaf(leaf, level - 1, x0 + half, y0),
+                    buildLeaf(leaf, level - 1, x0, y0 + half), buildLeaf(leaf, level - 1, x0 + half, y0 + half));
+    }
+    
+    // the 8x8 cells of a level-3 node as the bits of buildLeaf
+    uint64_t leafBits(uint32_t index, uint32_t level, int x0, int y0) {
+        if(level == 0) return (uint64_t)index << (y0 * 8 + x0);
+        
+        const Node n = nodes[index];
+        int half = 1 << (level - 1);
+        return leafBits(n.nw, level - 1, x0, y0) | leafBits(n.ne, level - 1, x0 + half, y0) | leafBits(n.sw, level - 1, x0, y0 + half) | leafBits(n.se, level - 1, x0 + half, y0 + half);
+    }
+    
+    // the key of the leaf (x, y) in the order of the quadrants nw, ne, sw, se on every level, the sorted keys of a node are its quadrants in turn
+    static uint64_t leafKey(uint32_t x, uint32_t y) {
+        uint64_t key = 0;
+        for(int bit = 0; bit < 32; bit++) key |= (uint64_t)((x >> bit) & 1) << (2 * bit) | (uint64_t)((y >> bit) & 1) << (2 * bit + 1);
+        return key;
+    }
+    
+    // the node with the leaves [begin, end), sorted by key, set on top of its cells; only the paths to the leaves are joined again
+    uint32_t insertLeaves(uint32_t index, const std::pair<uint64_t, uint64_t>* begin, const std::pair<uint64_t, uint64_t>* end) {
+        const Node n = nodes[index];
+        if(n.level == 3) return buildLeaf(leafBits(index, 3, 0, 0) | begin->second, 3, 0, 0);
+        
+        uint32_t children[4] = {n.nw, n.ne, n.sw, n.se};
+        int shift = 2 * (n.level - 4);
+        for(int q = 0; q < 4 && begin != end; q++) {
+            const std::pair<uint64_t, uint64_t>* quadrant_end = begin;
+            while(quadrant_end != end && (int)((quadrant_end->first >> shift) & 3) == q) quadrant_end++;
+            if(quadrant_end != begin) children[q] = insertLeaves(children[q], begin, quadrant_end);
+            begin = quadrant_end;
+        }
+        
+        return join(children[0], children[1], children[2], children[3]);
+    }
+    
+    // the torus on a board that is not square: the square root repeats the board along its shorter side, width_level and height_level are log2 of the sides
+    uint32_t repeatBoard(uint32_t index, uint32_t width_level, uint32_t height_level) {
+        const Node n = nodes[index];
+        if(n.level <= width_level && n.level <= height_level) return index;
+        
+        if(n.level > width_level) {
+            uint32_t west = repeatBoard(n.nw, width_level, height_level), south_west = repeatBoard(n.sw, width_level, height_level);
+            return join(west, west, south_west, south_west);
+        }
+        uint32_t north = repeatBoard(n.nw, width_level, height_level), north_east = repeatBoard(n.ne, width_level, height_level);
+        return join(north, north_east, north, north_east);
+    }
+    
+    void resize(int width_u, int height_u) {
+        width = width_u;
+        height = height_u;
+        generation = 0;
+        
+        reset();
+        
+        if(torus && ((width & (width - 1)) != 0 || (height & (height - 1)) != 0)) {
+            std::cerr << "ERROR: HASHLIFE: THE TORUS NEEDS POWER-OF-TWO BOARD SIDES, USE hashlife-plane FOR A BOARD OF " << width << "x" << height << std::endl;
+            exit(-1);
+        }
+        
+        origin_x = 0;
+        origin_y = 0;
+    }
+    
+    // the smallest square that covers the board, at least 4x4 for the base case
+    uint32_t boardLevel() const {
+        uint32_t level = 2;
+        while((1LL << level) < width || (1LL << level) < height) level++;
+        return level;
+    }
+    
+    static uint64_t hashMul(uint64_t a, uint64_t b) {
+        unsigned __int128 product = (unsigned __int128)a * b;
+        uint64_t r = (uint64_t)(product & HASHLIFE_HASH_PRIME) + (uint64_t)(product >> 61);
+        r = (r & HASHLIFE_HASH_PRIME) + (r >> 61);
+        return r >= HASHLIFE_HASH_PRIME ? r - HASHLIFE_HASH_PRIME : r;
+    }
+    
+    static uint64_t hashPow(uint64_t base, unsigned long long exponent) {
+        uint64_t power = 1;
+        for(; exponent > 0; exponent >>= 1) {
+            if(exponent & 1) power = hashMul(power, base);
+            base = hashMul(base, base);
+        }
+        return power;
+    }
+    
+    // the sum of X^x Y^y over the alive cells (x, y) of the node, the same for every copy of the node
+    uint64_t nodeHash(uint32_t index, std::unordered_map<uint32_t, uint64_t>& hashes) {
+        const Node n = nodes[index];
+        if(n.level == 0 || n.population == 0) return n.population;
+        
+        auto it = hashes.find(index);
+        if(it != hashes.end()) return it->second;
+        
+        uint64_t x_half = hashPow(HASHLIFE_HASH_X, 1ULL << (n.level - 1)), y_half = hashPow(HASHLIFE_HASH_Y, 1ULL << (n.level - 1));
+        uint64_t hash = nodeHash(n.nw, hashes);
+        hash += hashMul(x_half, nodeHash(n.ne, hashes));
+        hash += hashMul(y_half, nodeHash(n.sw, hashes));
+        hash = hash % HASHLIFE_HASH_PRIME + hashMul(hashMul(x_half, y_half), nodeHash(n.se, hashes));
+        hash %= HASHLIFE_HASH_PRIME;
+        
+        hashes[index] = hash;
+        return hash;
+    }
+    
+    // the sum of X^x Y^y over the alive cells (x, y) of the board, the nodes inside the board are hashed once whatever their position
+    uint64_t hashRegion(uint32_t index, long long x0, long long y0, std::unordered_map<uint32_t, uint64_t>& hashes) {
+        const Node& n = nodes[index];
+        long long size = 1LL << n.level;
+        
+        if(n.population == 0 || x0 >= width || y0 >= height || x0 + size <= 0 || y0 + size <= 0) return 0;
+        
+        if(x0 >= 0 && y0 >= 0 && x0 + size <= width && y0 + size <= height) {
+            return hashMul(hashMul(hashPow(HASHLIFE_HASH_X, x0), hashPow(HASHLIFE_HASH_Y, y0)), nodeHash(index, hashes));
+        }
+        
+        long long half = size / 2;
+        uint64_t hash = hashRegion(n.nw, x0, y0, hashes) + hashRegion(n.ne, x0 + half, y0, hashes);
+        hash = hash % HASHLIFE_HASH_PRIME + hashRegion(n.sw, x0, y0 + half, hashes);
+        hash = hash % HASHLIFE_HASH_PRIME + hashRegion(n.se, x0 + half, y0 + half, hashes);
+        return hash % HASHLIFE_HASH_PRIME;
+    }
+    
+    uint64_t countRegion(uint32_t index, long long x0, long long y0) {
+        const Node& n = nodes[index];
+        long long size = 1LL << n.level;
+        
+        if(n.population == 0 || x0 >= width || y0 >= height || x0 + size <= 0 || y0 + size <= 0) return 0;
+        if(x0 >= 0 && y0 >= 0 && x0 + size <= width && y0 + size <= height) return n.population;
+        
+        long long half = size / 2;
+        return countRegion(n.nw, x0, y0) + countRegion(n.ne, x0 + half, y0) + countRegion(n.sw, x0, y0 + half) + countRegion(n.se, x0 + half, y0 + half);
+    }
+    
+    void fill(unsigned char* cells, uint32_t index, long long x0, long long y0) {
+        const Node& n = nodes[index];
+        long long size = 1LL << n.level;
+        
+        if(n.population == 0 || x0 >= width || y0 >= height || x0 + size <= 0 || y0 + size <= 0) return;
+        
+        if(n.level == 0) {
+            cells[(size_t)y0 * width + x0] = COLOR_MAX;
+            return;
+        }
+        
+        long long half = size / 2;
+        fill(cells, n.nw, x0, y0);
+        fill(cells, n.ne, x0 + half, y0);
+        fill(cells, n.sw, x0, y0 + half);
+        fill(cells, n.se, x0 + half, y0 + half);
+    }
+    
+    void reset() {
+        nodes.clear();
+        nodes_free.clear();
+        nodes_table.clear();
+        empty_nodes.clear();
+        nodes_held.clear();
+        nodes_limit = nodes_max;
+        
+        for(uint32_t i = 0; i < 2; i++) {
+            Node leaf = {0, 0, 0, 0, HASHLIFE_NONE, 0, i, false};
+            nodes.push_back(leaf);
+        }
+        empty_nodes.push_back(0);
+        
+        step_log = -1;
+    }
+
+public:
+    // on_plane: place the board on an infinite empty plane instead of wrapping it around
+    EngineHashLife(bool on_plane = false, size_t nodes_max_u = HASHLIFE_NODES_MAX) : nodes_max(nodes_max_u), nodes_limit(nodes_max_u), step_log(-1), torus(!on_plane), root(0), origin_x(0), origin_y(0) {
+        reset();
+    }
+    
+    const char* name() const {
+        return torus ? "hashlife" : "hashlife-plane";
+    }
+    
+    // the memoized quadtree does not stream the board
+    double bytesPerCell() const {
+        return 0.0;
+    }
+    
+    void setRule(const Rule& rule_u) {
+        requireTwoStates(rule_u, name());
+        
+        // the empty nodes have to stay empty, the memoization relies on it
+        if(rule_u.birth & 1u) {
+            std::cerr << "ERROR: HASHLIFE: RULES WITH B0 ARE NOT SUPPORTED: " << ruleString(rule_u) << std::endl;
+            exit(-1);
+        }
+        
+        // the memoized results are only valid for one rule
+        if(rule != rule_u) for(Node& node : nodes) node.result = HASHLIFE_NONE;
+        rule = rule_u;
+    }
+    
+    void load(const unsigned char* cells, int width_u, int height_u) {
+        resize(width_u, height_u);
+        root = build([cells, this](int x, int y) { return cells[(size_t)y * width + x] > 0 ? 1u : 0u; }, boardLevel(), 0, 0);
+    }
+
+    // the runs are gathered into 8x8 leaves, in batches of HASHLIFE_LOAD_LEAVES inserted into the quadtree, so the extra memory does not grow with the area of the board
+    // the runs can come in any order; the boards with a side below 8 cells go through one bit per cell
+    void loadRuns(CellRuns& runs, int width_u, int height_u) {
+        resize(width_u, height_u);
+        
+        if(width >= 8 && height >= 8) {
+            uint32_t width_level = 0, height_level = 0;
+            while((1LL << width_level) < width) width_level++;
+            while((1LL << height_level) < height) height_level++;
+            
+            // on the torus the runs fill the corner of the board, the rest of the square root is repeated from it at the end
+            root = emptyNode(boardLevel());
+            
+            std::unordered_map<uint64_t, uint64_t> leaves;
+            std::vector<std::pair<uint64_t, uint64_t>> leaves_sorted;
+            auto insert = [this, &leaves, &leaves_sorted]() {
+                leaves_sorted.assign(leaves.begin(), leaves.end());
+                std::sort(leaves_sorted.begin(), leaves_sorted.end());
+                root = insertLeaves(root, leaves_sorted.data(), leaves_sorted.data() + leaves_sorted.size());
+                leaves.clear();
+                
+                if(nodesNum() > nodes_limit) collectGarbage();
+            };
+            
+            runs.forEachRun([&leaves, &insert](int x, int y, int length) {
+                for(int x_end = x + length; x < x_end;) {
+                    int x_leaf_end = std::min(x_end, (x & ~7) + 8);
+                    uint64_t row = ((1ULL << (x_leaf_end - x)) - 1) << (x & 7);
+                    leaves[leafKey((uint32_t)x >> 3, (uint32_t)y >> 3)] |= row << ((y & 7) * 8);
+                    x = x_leaf_end;
+                    
+                    if(leaves.size() >= HASHLIFE_LOAD_LEAVES) insert();
+                }
+            });
+            if(!leaves.empty()) insert();
+            
+            if(torus && width != height) root = repeatBoard(root, width_level, height_level);
+            return;
+        }
+        
+        size_t words_num = ((size_t)width + 63) / 64;
+        std::vector<uint64_t> bits(words_num * height, 0);
+        runs.forEachRun([&bits, words_num](int x, int y, int length) {
+            for(int x_end = x + length; x < x_end; x++) bits[(size_t)y * words_num + (x >> 6)] |= 1ULL << (x & 63);
+        });
+        
+        root = build([&bits, words_num](int x, int y) { return (uint32_t)(bits[(size_t)y * words_num + (x >> 6)] >> (x & 63)) & 1u; }, boardLevel(), 0, 0);
+    }
+    
+    // load a board given as a quadtree, the last node is the root and covers the whole board - the nodes are joined as they are, the cells are never visited
+    void loadQuadtree(const std::vector<QuadtreeNode>& tree) {
+        uint32_t level = tree.empty() ? 0 : tree.back().level;
+        if(level < 3 || level > HASHLIFE_LEVEL_MAX) {
+            std::cerr << "ERROR: HASHLIFE: THE QUADTREE HAS THE LEVEL " << level << ", IT HAS TO BE 3.." << HASHLIFE_LEVEL_MAX << std::endl;
+            exit(-1);
+        }
+        resize(1 << level, 1 << level);
+        
+        std::vector<uint32_t> indices(tree.size(), 0);
+        for(size_t i = 1; i < tree.size(); i++) {
+            const QuadtreeNode& node = tree[i];
+            if(node.level == 3) {
+                indices[i] = buildLeaf(node.leaf, 3, 0, 0);
+            } else {
+                uint32_t empty = emptyNode(node.level - 1);
+                indices[i] = join(node.nw ? indices[node.nw] : empty, node.ne ? indices[node.ne] : empty,
+                                  node.sw ? indices[node.sw] : empty, node.se ? indices[node.se] : empty);
+            }
+        }
+        root = indices.back();
+    }
+    
+    void step(unsigned int generations = 1) {
+        // the largest power-of-two steps first, a step size change drops only the memoized results of the levels it changes
+        for(int bit = 31; bit >= 0; bit--) {
+            if(generations & (1u << bit)) advance((unsigned int)bit);
+        }
+    }
+    
+    // advance the board by 2^step_log_u generations at once, e.g. step_log_u = 30 for a billion generations
+    void stepExponential(unsigned int step_log_u) {
+        advance(step_log_u);
+    }
+    
+    // the alive cells are all reported as COLOR_MAX, the skipped generations do not tell the newborn cells apart
+    void read(unsigned char* cells) {
+        std::fill(cells, cells + (size_t)width * height, 0);
+        fill(cells, root, origin_x, origin_y);
+    }
+    
+    uint64_t population() const {
+        return nodes[root].population;
+    }
+    
+    // the alive cells inside the board, population() counts also the ones the plane carried away from it
+    uint64_t boardPopulation() {
+        return countRegion(root, origin_x, origin_y);
+    }
+    
+    // a hash of the alive cells of the board computed on the quadtree, without reading the board into bytes - it is not the stateHash() of the other engines
+    uint64_t quadtreeHash() {
+        std::unordered_map<uint32_t, uint64_t> hashes;
+        return hashRegion(root, origin_x, origin_y, hashes);
+    }
+    
+    size_t nodesNum() const {
+        return nodes.size() - nodes_free.size();
+    }
+    
+    // the most nodes the cache has held at once, including the ones built in the middle of a step
+    size_t nodesPeak() const {
+        return nodes.size();
+    }
+};
+
+#endif /* engine_hashlife_h */
@@ -0,0 +1,134 @@
+//
+//  engine_lenia.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef engine_lenia_h
+#define engine_lenia_h
+
+// include the standard libraries
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#include "engine.h"
+#include "fft.h"
+
+// CPU backend for the Lenia rules, one float per cell
+// the potential is the circular convolution of the board with the kernel of the rule, done as a product of their Fourier transforms,
+// so a generation costs O(N log N) in the number of cells whatever the radius of the kernel
+class EngineLenia : public Engine {
+private:
+    std::vector<float> cells; // states in [0, 1]
+    std::vector<Complex> potential; // the transform of the board, then the potential
+    std::vector<Complex> weights_spectrum; // the transform of the kernel, divided by width * height for the inverse transform
+    FFT2D fft;
+    StripPool strips;
+    
+    RuleLenia rule_lenia;
+    
+    void createSpectrum() {
+        fft = FFT2D(width, height);
+        
+        std::vector<float> weights = leniaWeights(rule_lenia, width, height);
+        float scale = 1.0f / ((float)width * height);
+        
+        weights_spectrum.resize(weights.size());
+        for(size_t i = 0; i < weights.size(); i++) weights_spectrum[i] = Complex(weights[i] * scale, 0.0f);
+        fft.transform(weights_spectrum.data(), false, strips);
+    }
+    
+    void fillRows(int y_begin, int y_end) {
+        for(size_t i = (size_t)y_begin * width; i < (size_t)y_end * width; i++) potential[i] = Complex(cells[i], 0.0f);
+    }
+    
+    void multiplyRows(int y_begin, int y_end) {
+        for(size_t i = (size_t)y_begin * width; i < (size_t)y_end * width; i++) potential[i] *= weights_spectrum[i];
+    }
+    
+    void growRows(int y_begin, int y_end) {
+        float dt = 1.0f / rule_lenia.time_steps;
+        
+        for(size_t i = (size_t)y_begin * width; i < (size_t)y_end * width; i++) {
+            float state = cells[i] + dt * leniaGrowth(potential[i].real(), rule_lenia.mu, rule_lenia.sigma);
+            cells[i] = std::min(1.0f, std::max(0.0f, state));
+        }
+    }
+    
+    void iterate() {
+        strips.run(height, [this](int y_begin, int y_end) { fillRows(y_begin, y_end); });
+        fft.transform(potential.data(), false, strips);
+        strips.run(height, [this](int y_begin, int y_end) { multiplyRows(y_begin, y_end); });
+        fft.transform(potential.data(), true, strips);
+        strips.run(height, [this](int y_begin, int y_end) { growRows(y_begin, y_end); });
+        
+        generation++;
+    }
+
+public:
+    EngineLenia(unsigned int threads_num_u = 0) : strips(defaultThreadsNum(threads_num_u)) {
+    }
+    
+    const char* name() const {
+        return "lenia";
+    }
+    
+    // the float states and the complex potential: filled, transformed twice (read and write by the rows, then by the columns), multiplied and read by the growth
+    double bytesPerCell() const {
+        return 4.0 + 8.0 + 2 * 4 * 8.0 + 3 * 8.0 + 8.0 + 2 * 4.0;
+    }
+    
+    // the cells are not alive or dead, only the default rule is accepted so that the callers can set it unconditionally
+    void setRule(const Rule& rule_u) {
+        if(rule_u != Rule()) {
+            std::cerr << "ERROR: LENIA: RUNS ONLY LENIA RULES, CANNOT RUN: " << ruleString(rule_u) << std::endl;
+            exit(-1);
+        }
+        
+        rule = rule_u;
+    }
+    
+    void setRuleLenia(const RuleLenia& rule_lenia_u) {
+        rule_lenia = rule_lenia_u;
+        if(width > 0) createSpectrum();
+    }
+    
+    const RuleLenia& ruleLenia() const {
+        return rule_lenia;
+    }
+    
+    // the bytes of the board become the states: a board of 0 and 1 like the other engines take (the textures, the patterns, the soups) gives the states 0 and 1,
+    // a board with larger values holds the states scaled to 0..COLOR_MAX as read() returns them
+    void load(const unsigned char* cells_in, int width_u, int height_u) {
+        width = width_u;
+        height = height_u;
+        generation = 0;
+        
+        cells.resize((size_t)width * height);
+        unsigned char cell_max = cells.empty() ? 0 : *std::max_element(cells_in, cells_in + cells.size());
+        float scale = cell_max > 1 ? 1.0f / COLOR_MAX : 1.0f;
+        for(size_t i = 0; i < cells.size(); i++) cells[i] = cells_in[i] * scale;
+        potential.resize(cells.size());
+        
+        createSpectrum();
+    }
+    
+    void step(unsigned int generations = 1) {
+        for(unsigned int i = 0; i < generations; i++) iterate();
+    }
+    
+    // the states scaled to 0..COLOR_MAX, the cells with a state below 1 / 510 read as dead
+    void read(unsigned char* cells_out) {
+        for(size_t i = 0; i < cells.size(); i++) cells_out[i] = (unsigned char)(cells[i] * COLOR_MAX + 0.5f);
+    }
+    
+    // the states themselves
+    void readStates(float* states) const {
+        std::copy(cells.begin(), cells.end(), states);
+    }
+};
+
+#endif /* engine_lenia_h */
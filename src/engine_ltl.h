@@ -0,0 +1,192 @@
+//
+//  engine_ltl.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef engine_ltl_h
+#define engine_ltl_h
+
+// include the standard libraries
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+
+#include "engine.h"
+
+// CPU backend for the Larger-than-Life rules, one byte per cell
+// the neighbour counts come from a summed-area table rebuilt every generation, so a count costs 4 lookups whatever the radius
+// the table is built over the board wrapped around with a margin of R cells; for the von Neumann neighbourhood the board is first rotated by 45 degrees
+// (u = px + py, v = px - py), which turns the diamonds into squares
+class EngineLtL : public Engine {
+private:
+    std::vector<unsigned char> cells_in, cells_out; // 0 or 1
+    std::vector<int32_t> sums; // sums[row * sums_width + col]: sum of the cells above and to the left, the first row and column are 0
+    int sums_width, sums_height;
+    StripPool strips;
+    
+    RuleLtL rule_ltl;
+    
+    void createSums() {
+        int padded_width = width + 2 * rule_ltl.radius;
+        int padded_height = height + 2 * rule_ltl.radius;
+        
+        if(rule_ltl.von_neumann) {
+            sums_width = padded_width + padded_height;
+            sums_height = padded_width + padded_height;
+        } else {
+            sums_width = padded_width + 1;
+            sums_height = padded_height + 1;
+        }
+        
+        sums.assign((size_t)sums_width * sums_height, 0);
+    }
+    
+    inline int32_t boxSum(int row_begin, int row_end, int col_begin, int col_end) const {
+        // the sum over the rows [row_begin, row_end] and the columns [col_begin, col_end]
+        const int32_t* row_top = &sums[(size_t)row_begin * sums_width];
+        const int32_t* row_bottom = &sums[(size_t)(row_end + 1) * sums_width];
+        return row_bottom[col_end + 1] - row_top[col_end + 1] - row_bottom[col_begin] + row_top[col_begin];
+    }
+    
+    void fillRows(int py_begin, int py_end) {
+        int radius = rule_ltl.radius;
+        int padded_width = width + 2 * radius;
+        int padded_height = height + 2 * radius;
+        
+        for(int py = py_begin; py < py_end; py++) {
+            const unsigned char* row = &cells_in[(size_t)(((py - radius) % height + height) % height) * width];
+            
+            for(int px = 0; px < padded_width; px++) {
+                unsigned char cell = row[((px - radius) % width + width) % width];
+                
+                if(rule_ltl.von_neumann) sums[(size_t)(px + py + 1) * sums_width + px - py + padded_height] = cell;
+                else sums[(size_t)(py + 1) * sums_width + px + 1] = cell;
+            }
+        }
+    }
+    
+    void scanRows(int row_begin, int row_end) {
+        for(int row = row_begin; row < row_end; row++) {
+            int32_t* sums_row = &sums[(size_t)row * sums_width];
+            for(int col = 1; col < sums_width; col++) sums_row[col] += sums_row[col - 1];
+        }
+    }
+    
+    void scanCols(int col_begin, int col_end) {
+        // row by row, so that every thread reads memory sequentially
+        for(int row = 1; row < sums_height; row++) {
+            int32_t* sums_row = &sums[(size_t)row * sums_width];
+            const int32_t* sums_row_up = &sums[(size_t)(row - 1) * sums_width];
+            for(int col = col_begin; col < col_end; col++) sums_row[col] += sums_row_up[col];
+        }
+    }
+    
+    void iterateRows(int y_begin, int y_end) {
+        int radius = rule_ltl.radius;
+        int padded_height = height + 2 * radius;
+        
+        for(int y = y_begin; y < y_end; y++) {
+            for(int x = 0; x < width; x++) {
+                int px = x + radius, py = y + radius;
+                unsigned char alive = cells_in[(size_t)y * width + x];
+                
+                int32_t counter;
+                if(rule_ltl.von_neumann) {
+                    int u = px + py, v = px - py + padded_height - 1;
+                    counter = boxSum(u - radius, u + radius, v - radius, v + radius);
+                } else {
+                    counter = boxSum(py - radius, py + radius, px - radius, px + radius);
+                }
+                if(!rule_ltl.centre) counter -= alive;
+                
+                unsigned char next;
+                if(alive) next = rule_ltl.survival_min <= counter && counter <= rule_ltl.survival_max;
+                else next = rule_ltl.birth_min <= counter && counter <= rule_ltl.birth_max;
+                
+                cells_out[(size_t)y * width + x] = next;
+            }
+        }
+    }
+    
+    void iterate() {
+        int padded_height = height + 2 * rule_ltl.radius;
+        
+        // the rotated board does not cover every entry of the table, the gaps have to be 0
+        if(rule_ltl.von_neumann) std::fill(sums.begin(), sums.end(), 0);
+        
+        strips.run(padded_height, [this](int py_begin, int py_end) { fillRows(py_begin, py_end); });
+        strips.run(sums_height, [this](int row_begin, int row_end) { scanRows(row_begin, row_end); });
+        strips.run(sums_width, [this](int col_begin, int col_end) { scanCols(col_begin, col_end); });
+        strips.run(height, [this](int y_begin, int y_end) { iterateRows(y_begin, y_end); });
+        
+        cells_in.swap(cells_out);
+        generation++;
+    }
+
+public:
+    EngineLtL(unsigned int threads_num_u = 0) : sums_width(0), sums_height(0), strips(defaultThreadsNum(threads_num_u)) {
+    }
+    
+    const char* name() const {
+        return "ltl";
+    }
+    
+    // the cells, plus the 32-bit table: filled, scanned twice (read and write) and read 4 times
+    double bytesPerCell() const {
+        return 2.0 + 4.0 * (1 + 2 + 2 + 4);
+    }
+    
+    // a Life-like rule runs as a radius 1 rule, if its counts are ranges
+    void setRule(const Rule& rule_u) {
+        requireTwoStates(rule_u, name());
+        
+        RuleLtL rule_ltl_u;
+        if(!ruleToLtL(rule_u, rule_ltl_u)) {
+            std::cerr << "ERROR: LTL: THE RULE IS NOT A RANGE OF COUNTS: " << ruleString(rule_u) << std::endl;
+            exit(-1);
+        }
+        
+        rule = rule_u;
+        setRuleLtL(rule_ltl_u);
+    }
+    
+    void setRuleLtL(const RuleLtL& rule_ltl_u) {
+        rule_ltl = rule_ltl_u;
+        if(width > 0) createSums();
+    }
+    
+    const RuleLtL& ruleLtL() const {
+        return rule_ltl;
+    }
+    
+    void load(const unsigned char* cells, int width_u, int height_u) {
+        width = width_u;
+        height = height_u;
+        generation = 0;
+        
+        cells_in.resize((size_t)width * height);
+        cells_out.assign((size_t)width * height, 0);
+        for(size_t i = 0; i < cells_in.size(); i++) cells_in[i] = cells[i] > 0;
+        
+        createSums();
+    }
+    
+    void step(unsigned int generations = 1) {
+        for(unsigned int i = 0; i < generations; i++) iterate();
+    }
+    
+    void read(unsigned char* cells) {
+        // the previous generation is still in cells_out, use it to tell the newborn cells from the surviving ones
+        for(size_t i = 0; i < cells_in.size(); i++) {
+            unsigned char col = 0;
+            if(cells_in[i]) col = (generation == 0 || cells_out[i]) ? COLOR_MAX : COLOR_MID;
+            cells[i] = col;
+        }
+    }
+};
+
+#endif /* engine_ltl_h */
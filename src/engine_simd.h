@@ -0,0 +1,274 @@
+//
+//  engine_simd.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef engine_simd_h
+#define engine_simd_h
+
+// include the standard libraries
+#include <vector>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+#include "engine.h"
+
+enum SIMDLevel {
+    SIMD_AUTO,
+    SIMD_SCALAR,
+    SIMD_SSE42,
+    SIMD_AVX2,
+    SIMD_AVX512
+};
+
+// the row kernels compute the cells [1, width] of the padded output row, the cells 0 and width + 1 are the wrapped halo columns
+// they are specialized for the rule: Life lives if (counter | alive) == 3, i.e. the counter is 3, or 2 for an alive cell (the cells are stored as 0 or 1),
+// the other rules look the next state up in the rule table with byte shuffles
+typedef void (*SIMDRowKernel)(const unsigned char*, const unsigned char*, const unsigned char*, unsigned char*, int, const RuleTable*);
+
+template<uint32_t BIRTH, uint32_t SURVIVAL>
+inline void iterateRowScalar(const unsigned char* up, const unsigned char* row, const unsigned char* down, unsigned char* out, int x_begin, int width, const RuleTable* table) {
+    for(int x = x_begin; x < width; x++) {
+        unsigned char counter = up[x] + up[x + 1] + up[x + 2] + row[x] + row[x + 2] + down[x] + down[x + 1] + down[x + 2];
+        
+        if(ruleIsLife(BIRTH, SURVIVAL)) out[x + 1] = (counter | row[x + 1]) == 3;
+        else if(BIRTH == RULE_DYNAMIC) out[x + 1] = row[x + 1] ? table->survival[counter] : table->birth[counter];
+        else out[x + 1] = ruleNext(BIRTH, SURVIVAL, row[x + 1], counter);
+    }
+}
+
+template<uint32_t BIRTH, uint32_t SURVIVAL>
+inline void iterateRowScalar(const unsigned char* up, const unsigned char* row, const unsigned char* down, unsigned char* out, int width, const RuleTable* table) {
+    iterateRowScalar<BIRTH, SURVIVAL>(up, row, down, out, 0, width, table);
+}
+
+#ifdef SIMD_X86
+template<uint32_t BIRTH, uint32_t SURVIVAL>
+__attribute__((target("sse4.2")))
+inline void iterateRowSSE42(const unsigned char* up, const unsigned char* row, const unsigned char* down, unsigned char* out, int width, const RuleTable* table) {
+    const __m128i three = _mm_set1_epi8(3), one = _mm_set1_epi8(1), zero = _mm_setzero_si128();
+    const __m128i birth = _mm_loadu_si128((const __m128i*)table->birth), survival = _mm_loadu_si128((const __m128i*)table->survival);
+    
+    int x = 0;
+    for(; x + 16 <= width; x += 16) {
+        __m128i counter = _mm_add_epi8(_mm_loadu_si128((const __m128i*)(up + x)), _mm_loadu_si128((const __m128i*)(up + x + 1)));
+        counter = _mm_add_epi8(counter, _mm_loadu_si128((const __m128i*)(up + x + 2)));
+        counter = _mm_add_epi8(counter, _mm_loadu_si128((const __m128i*)(row + x)));
+        counter = _mm_add_epi8(counter, _mm_loadu_si128((const __m128i*)(row + x + 2)));
+        counter = _mm_add_epi8(counter, _mm_loadu_si128((const __m128i*)(down + x)));
+        counter = _mm_add_epi8(counter, _mm_loadu_si128((const __m128i*)(down + x + 1)));
+        counter = _mm_add_epi8(counter, _mm_loadu_si128((const __m128i*)(down + x + 2)));
+        
+        __m128i alive = _mm_loadu_si128((const __m128i*)(row + x + 1));
+        __m128i next;
+        if(ruleIsLife(BIRTH, SURVIVAL)) next = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(counter, alive), three), one);
+        else next = _mm_blendv_epi8(_mm_shuffle_epi8(birth, counter), _mm_shuffle_epi8(survival, counter), _mm_sub_epi8(zero, alive));
+        _mm_storeu_si128((__m128i*)(out + x + 1), next);
+    }
+    
+    iterateRowScalar<BIRTH, SURVIVAL>(up, row, down, out, x, width, table);
+}
+
+template<uint32_t BIRTH, uint32_t SURVIVAL>
+__attribute__((target("avx2")))
+inline void iterateRowAVX2(const unsigned char* up, const unsigned char* row, const unsigned char* down, unsigned char* out, int width, const RuleTable* table) {
+    const __m256i three = _mm256_set1_epi8(3), one = _mm256_set1_epi8(1), zero = _mm256_setzero_si256();
+    const __m256i birth = _mm256_loadu_si256((const __m256i*)table->birth), survival = _mm256_loadu_si256((const __m256i*)table->survival);
+    
+    int x = 0;
+    for(; x + 32 <= width; x += 32) {
+        __m256i counter = _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)(up + x)), _mm256_loadu_si256((const __m256i*)(up + x + 1)));
+        counter = _mm256_add_epi8(counter, _mm256_loadu_si256((const __m256i*)(up + x + 2)));
+        counter = _mm256_add_epi8(counter, _mm256_loadu_si256((const __m256i*)(row + x)));
+        counter = _mm256_add_epi8(counter, _mm256_loadu_si256((const __m256i*)(row + x + 2)));
+        counter = _mm256_add_epi8(counter, _mm256_loadu_si256((const __m256i*)(down + x)));
+        counter = _mm256_add_epi8(counter, _mm256_loadu_si256((const __m256i*)(down + x + 1)));
+        counter = _mm256_add_epi8(counter, _mm256_loadu_si256((const __m256i*)(down + x + 2)));
+        
+        __m256i alive = _mm256_loadu_si256((const __m256i*)(row + x + 1));
+        __m256i next;
+        if(ruleIsLife(BIRTH, SURVIVAL)) next = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(counter, alive), three), one);
+        else next = _mm256_blendv_epi8(_mm256_shuffle_epi8(birth, counter), _mm256_shuffle_epi8(survival, counter), _mm256_sub_epi8(zero, alive));
+        _mm256_storeu_si256((__m256i*)(out + x + 1), next);
+    }
+    
+    iterateRowScalar<BIRTH, SURVIVAL>(up, row, down, out, x, width, table);
+}
+
+template<uint32_t BIRTH, uint32_t SURVIVAL>
+__attribute__((target("avx512f,avx512bw")))
+inline void iterateRowAVX512(const unsigned char* up, const unsigned char* row, const unsigned char* down, unsigned char* out, int width, const RuleTable* table) {
+    const __m512i three = _mm512_set1_epi8(3), one = _mm512_set1_epi8(1);
+    const __m512i birth = _mm512_loadu_si512((const void*)table->birth), survival = _mm512_loadu_si512((const void*)table->survival);
+    
+    int x = 0;
+    for(; x + 64 <= width; x += 64) {
+        __m512i counter = _mm512_add_epi8(_mm512_loadu_si512((const void*)(up + x)), _mm512_loadu_si512((const void*)(up + x + 1)));
+        counter = _mm512_add_epi8(counter, _mm512_loadu_si512((const void*)(up + x + 2)));
+        counter = _mm512_add_epi8(counter, _mm512_loadu_si512((const void*)(row + x)));
+        counter = _mm512_add_epi8(counter, _mm512_loadu_si512((const void*)(row + x + 2)));
+        counter = _mm512_add_epi8(counter, _mm512_loadu_si512((const void*)(down + x)));
+        counter = _mm512_add_epi8(counter, _mm512_loadu_si512((const void*)(down + x + 1)));
+        counter = _mm512_add_epi8(counter, _mm512_loadu_si512((const void*)(down + x + 2)));
+        
+        __m512i alive = _mm512_loadu_si512((const void*)(row + x + 1));
+        __m512i next;
+        if(ruleIsLife(BIRTH, SURVIVAL)) {
+            __mmask64 mask = _mm512_cmpeq_epi8_mask(_mm512_or_si512(counter, alive), three);
+            next = _mm512_maskz_mov_epi8(mask, one);
+        } else {
+            next = _mm512_mask_blend_epi8(_mm512_test_epi8_mask(alive, alive), _mm512_shuffle_epi8(birth, counter), _mm512_shuffle_epi8(survival, counter));
+        }
+        _mm512_storeu_si512((void*)(out + x + 1), next);
+    }
+    
+    iterateRowScalar<BIRTH, SURVIVAL>(up, row, down, out, x, width, table);
+}
+#endif
+
+// pick the widest instruction set supported by the CPU the program runs on
+inline SIMDLevel detectSIMDLevel() {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return SIMD_AVX512;
+    if(__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if(__builtin_cpu_supports("sse4.2")) return SIMD_SSE42;
+#endif
+    return SIMD_SCALAR;
+}
+
+template<uint32_t BIRTH, uint32_t SURVIVAL>
+struct SIMDRowSpecialization {
+    typedef SIMDRowKernel Kernel;
+    
+    static Kernel kernel(SIMDLevel level) {
+        switch(level) {
+#ifdef SIMD_X86
+            case SIMD_SSE42: return iterateRowSSE42<BIRTH, SURVIVAL>;
+            case SIMD_AVX2: return iterateRowAVX2<BIRTH, SURVIVAL>;
+            case SIMD_AVX512: return iterateRowAVX512<BIRTH, SURVIVAL>;
+#endif
+            default: return iterateRowScalar<BIRTH, SURVIVAL>;
+        }
+    }
+};
+
+inline SIMDRowKernel simdRowKernel(SIMDLevel level, const Rule& rule = Rule()) {
+    return specializeRule<SIMDRowSpecialization>(rule, level);
+}
+
+inline const char* simdLevelName(SIMDLevel level) {
+    switch(level) {
+        case SIMD_SSE42: return "sse4.2";
+        case SIMD_AVX2: return "avx2";
+        case SIMD_AVX512: return "avx512";
+        case SIMD_SCALAR: return "scalar";
+        default: return "auto";
+    }
+}
+
+// CPU backend with one byte per cell, stepped with explicit SIMD row kernels chosen at startup
+class EngineSIMD : public Engine {
+private:
+    std::vector<unsigned char> cells_in, cells_out;
+    int stride; // padded row length: the halo columns plus room for the vector loads past the end of the row
+    StripPool strips;
+    
+    SIMDLevel level;
+    SIMDRowKernel row_kernel;
+    RuleTable rule_table;
+    
+    void iterateRows(int y_begin, int y_end) {
+        for(int y = y_begin; y < y_end; y++) {
+            const unsigned char* up = &cells_in[(size_t)((y + height - 1) % height) * stride];
+            const unsigned char* row = &cells_in[(size_t)y * stride];
+            const unsigned char* down = &cells_in[(size_t)((y + 1) % height) * stride];
+            unsigned char* out = &cells_out[(size_t)y * stride];
+            
+            row_kernel(up, row, down, out, width, &rule_table);
+            
+            // wrap the row around
+            out[0] = out[width];
+            out[width + 1] = out[1];
+        }
+    }
+    
+    void iterate() {
+        strips.run(height, [this](int y_begin, int y_end) { iterateRows(y_begin, y_end); });
+        
+        cells_in.swap(cells_out);
+        generation++;
+    }
+
+public:
+    EngineSIMD(unsigned int threads_num_u = 0, SIMDLevel level_u = SIMD_AUTO) : strips(defaultThreadsNum(threads_num_u)) {
+        
+        SIMDLevel level_supported = detectSIMDLevel();
+        level = (level_u == SIMD_AUTO) ? level_supported : level_u;
+        if(level > level_supported) {
+            std::cerr << "ERROR: SIMD: INSTRUCTION SET NOT SUPPORTED BY THIS CPU: " << simdLevelName(level) << std::endl;
+            exit(-1);
+        }
+        
+        row_kernel = simdRowKernel(level, rule);
+    }
+    
+    const char* name() const {
+        return "simd";
+    }
+    
+    void setRule(const Rule& rule_u) {
+        requireTwoStates(rule_u, name());
+        rule = rule_u;
+        rule_table = RuleTable(rule);
+        row_kernel = simdRowKernel(level, rule);
+    }
+    
+    SIMDLevel simdLevel() const {
+        return level;
+    }
+    
+    void load(const unsigned char* cells, int width_u, int height_u) {
+        width = width_u;
+        height = height_u;
+        generation = 0;
+        
+        stride = ((width + 2 + 63) / 64 + 1) * 64;
+        
+        cells_in.assign((size_t)stride * height, 0);
+        cells_out.assign((size_t)stride * height, 0);
+        
+        for(int y = 0; y < height; y++) {
+            unsigned char* row = &cells_in[(size_t)y * stride];
+            for(int x = 0; x < width; x++) row[x + 1] = cells[(size_t)y * width + x] > 0;
+            
+            row[0] = row[width];
+            row[width + 1] = row[1];
+        }
+    }
+    
+    void step(unsigned int generations = 1) {
+        for(unsigned int i = 0; i < generations; i++) iterate();
+    }
+    
+    void read(unsigned char* cells) {
+        // the previous generation is still in cells_out, use it to tell the newborn cells from the surviving ones
+        for(int y = 0; y < height; y++) for(int x = 0; x < width; x++) {
+            size_t i = (size_t)y * stride + x + 1;
+            
+            unsigned char col = 0;
+            if(cells_in[i]) col = (generation == 0 || cells_out[i]) ? COLOR_MAX : COLOR_MID;
+            
+            cells[(size_t)y * width + x] = col;
+        }
+    }
+};
+
+#endif /* engine_simd_h */
@@ -0,0 +1,255 @@
+//
+//  engine_tiled.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef engine_tiled_h
+#define engine_tiled_h
+
+// include the standard libraries
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+
+#include "engine.h"
+#include "engine_simd.h"
+#include "thread_pool.h"
+
+#define TILE_BYTES (128 * 1024) // a tile and its halo rows should fit in the L2 cache
+#define TILE_COLS_MAX 512
+
+// CPU backend cutting the board into cache-sized tiles stepped by a work-stealing pool
+// there is no global barrier between the generations - a tile runs its next generation as soon as itself and its 8 neighbours have finished the current one
+// a tile is skipped when neither it nor its neighbours changed in the last generation, its output buffer then already holds the same state
+class EngineTiled : public Engine {
+private:
+    struct Tile {
+        int x_begin, x_end, y_begin, y_end;
+        int home_worker; // the worker that first touched the memory of the tile, every generation of the tile is queued on it
+        std::vector<int> neighbours; // the distinct tiles whose halo this tile reads (including itself), with the wrap around
+        std::atomic<int> waiting[2]; // neighbours yet to finish the previous generation, one counter per generation parity
+        bool changed[2]; // changed[g % 2]: the tile changed when producing the generation g
+    };
+    
+    std::unique_ptr<unsigned char[]> cells[2]; // padded rows like in EngineSIMD, cells[generation % 2] is the current state
+    int stride;
+    
+    int tiles_x, tiles_y;
+    std::unique_ptr<Tile[]> tiles;
+    
+    ThreadPool pool;
+    SIMDRowKernel row_kernel;
+    RuleTable rule_table;
+    
+    // state of the current step() call
+    unsigned int generations_target;
+    std::atomic<int> tiles_finished;
+    std::mutex finished_mutex;
+    std::condition_variable finished_cv;
+    
+    bool iterateTile(const Tile& tile, const unsigned char* cells_in, unsigned char* cells_out) {
+        int tile_width = tile.x_end - tile.x_begin;
+        bool changed = false;
+        
+        for(int y = tile.y_begin; y < tile.y_end; y++) {
+            const unsigned char* up = &cells_in[(size_t)((y + height - 1) % height) * stride];
+            const unsigned char* row = &cells_in[(size_t)y * stride];
+            const unsigned char* down = &cells_in[(size_t)((y + 1) % height) * stride];
+            unsigned char* out = &cells_out[(size_t)y * stride];
+            
+            row_kernel(up + tile.x_begin, row + tile.x_begin, down + tile.x_begin, out + tile.x_begin, tile_width, &rule_table);
+            
+            // the tiles at the edges of the board fill in the wrapped halo columns
+            if(tile.x_begin == 0) out[width + 1] = out[1];
+            if(tile.x_end == width) out[0] = out[width];
+            
+            if(!changed) changed = memcmp(out + tile.x_begin + 1, row + tile.x_begin + 1, tile_width) != 0;
+        }
+        
+        return changed;
+    }
+    
+    bool isActive(const Tile& tile, unsigned long long current) const {
+        for(int neighbour_index : tile.neighbours) if(tiles[neighbour_index].changed[current % 2]) return true;
+        return false;
+    }
+    
+    void runTile(int index, unsigned int step_generation) {
+        Tile& tile = tiles[index];
+        unsigned long long current = generation + step_generation;
+        
+        // the neighbours have all finished the current generation, so their change flags are final
+        if(isActive(tile, current)) tile.changed[(current + 1) % 2] = iterateTile(tile, cells[current % 2].get(), cells[(current + 1) % 2].get());
+        else tile.changed[(current + 1) % 2] = false;
+        
+        step_generation++;
+        if(step_generation == generations_target) {
+            if(++tiles_finished == tiles_x * tiles_y) {
+                std::lock_guard<std::mutex> lock(finished_mutex);
+                finished_cv.notify_all();
+            }
+            return;
+        }
+        
+        // hand the next generation over to the neighbours which now have all of their halo ready, on the worker next to their memory - the idle workers steal it when the load is uneven
+        for(int neighbour_index : tile.neighbours) {
+            Tile& neighbour = tiles[neighbour_index];
+            std::atomic<int>& waiting = neighbour.waiting[step_generation % 2];
+            
+            if(--waiting == 0) {
+                waiting = (int)neighbour.neighbours.size();
+                pool.submit([this, neighbour_index, step_generation] { runTile(neighbour_index, step_generation); }, neighbour.home_worker);
+            }
+        }
+    }
+    
+    void createTiles() {
+        int tile_cols = std::min(width, TILE_COLS_MAX);
+        int tile_rows = std::max(1, std::min(height, TILE_BYTES / (tile_cols + 2)));
+        
+        tiles_x = (width + tile_cols - 1) / tile_cols;
+        tiles_y = (height + tile_rows - 1) / tile_rows;
+        tiles.reset(new Tile[tiles_x * tiles_y]);
+        
+        for(int ty = 0; ty < tiles_y; ty++) for(int tx = 0; tx < tiles_x; tx++) {
+            Tile& tile = tiles[ty * tiles_x + tx];
+            
+            tile.x_begin = tx * tile_cols;
+            tile.x_end = std::min(width, (tx + 1) * tile_cols);
+            tile.y_begin = ty * tile_rows;
+            tile.y_end = std::min(height, (ty + 1) * tile_rows);
+            
+            // consecutive bands of tiles stay on the same worker, so that the worker touches contiguous pages
+            tile.home_worker = (int)((size_t)(ty * tiles_x + tx) * pool.size() / (tiles_x * tiles_y));
+            
+            tile.changed[0] = true;
+            tile.changed[1] = true;
+            
+            tile.neighbours.clear();
+            for(int j = -1; j <= 1; j++) for(int i = -1; i <= 1; i++) {
+                int neighbour_index = ((ty + j + tiles_y) % tiles_y) * tiles_x + (tx + i + tiles_x) % tiles_x;
+                if(std::find(tile.neighbours.begin(), tile.neighbours.end(), neighbour_index) == tile.neighbours.end()) tile.neighbours.push_back(neighbour_index);
+            }
+        }
+    }
+
+    // the buffers of a board of size width_u x height_u, holding cells_in or nothing when it is null
+    void allocate(const unsigned char* cells_in, int width_u, int height_u) {
+        width = width_u;
+        height = height_u;
+        generation = 0;
+        
+        stride = ((width + 2 + 63) / 64 + 1) * 64;
+        
+        // allocate without touching the memory, the first write to each tile happens on its home worker (first-touch NUMA placement)
+        for(int i = 0; i < 2; i++) cells[i].reset(new unsigned char[(size_t)stride * height]);
+        
+        createTiles();
+        
+        for(int t = 0; t < tiles_x * tiles_y; t++) {
+            pool.submit([this, t, cells_in] {
+                const Tile& tile = tiles[t];
+                for(int i = 0; i < 2; i++) for(int y = tile.y_begin; y < tile.y_end; y++) {
+                    unsigned char* row = &cells[i][(size_t)y * stride];
+                    if(tile.x_begin == 0) std::fill(row, row + 1, 0);
+                    std::fill(row + tile.x_begin + 1, row + tile.x_end + 1, 0);
+                    if(tile.x_end == width) std::fill(row + width + 1, row + stride, 0);
+                    if(i == 0 && cells_in) for(int x = tile.x_begin; x < tile.x_end; x++) row[x + 1] = cells_in[(size_t)y * width + x] > 0;
+                }
+            }, tiles[t].home_worker);
+        }
+        pool.wait();
+    }
+    
+    // the halo columns of the current state wrap around
+    void wrapColumns() {
+        for(int y = 0; y < height; y++) {
+            unsigned char* row = &cells[0][(size_t)y * stride];
+            row[0] = row[width];
+            row[width + 1] = row[1];
+        }
+    }
+
+public:
+    EngineTiled(unsigned int threads_num_u = 0) : tiles_x(0), tiles_y(0), pool(defaultThreadsNum(threads_num_u), true) {
+        row_kernel = simdRowKernel(detectSIMDLevel(), rule);
+    }
+    
+    const char* name() const {
+        return "tiled";
+    }
+    
+    void setRule(const Rule& rule_u) {
+        requireTwoStates(rule_u, name());
+        rule = rule_u;
+        rule_table = RuleTable(rule);
+        row_kernel = simdRowKernel(detectSIMDLevel(), rule);
+        
+        // the change flags were computed under the old rule
+        for(int t = 0; t < tiles_x * tiles_y; t++) {
+            tiles[t].changed[0] = true;
+            tiles[t].changed[1] = true;
+        }
+    }
+    
+    void load(const unsigned char* cells_in, int width_u, int height_u) {
+        allocate(cells_in, width_u, height_u);
+        wrapColumns();
+    }
+    
+    // the runs are written into the padded rows, after the tiles were zeroed on their home workers
+    void loadRuns(CellRuns& runs, int width_u, int height_u) {
+        allocate(nullptr, width_u, height_u);
+        
+        runs.forEachRun([this](int x, int y, int length) {
+            memset(&cells[0][(size_t)y * stride + x + 1], 1, length);
+        });
+        wrapColumns();
+    }
+    
+    void step(unsigned int generations = 1) {
+        if(generations == 0) return;
+        
+        generations_target = generations;
+        tiles_finished = 0;
+        
+        for(int t = 0; t < tiles_x * tiles_y; t++) {
+            for(int i = 0; i < 2; i++) tiles[t].waiting[i] = (int)tiles[t].neighbours.size();
+        }
+        for(int t = 0; t < tiles_x * tiles_y; t++) {
+            pool.submit([this, t] { runTile(t, 0); }, tiles[t].home_worker);
+        }
+        
+        {
+            std::unique_lock<std::mutex> lock(finished_mutex);
+            finished_cv.wait(lock, [this] { return tiles_finished == tiles_x * tiles_y; });
+        }
+        pool.wait();
+        
+        generation += generations;
+    }
+    
+    void read(unsigned char* cells_out) {
+        const unsigned char* cells_current = cells[generation % 2].get();
+        const unsigned char* cells_previous = cells[(generation + 1) % 2].get();
+        
+        // the previous generation is still in the other buffer, use it to tell the newborn cells from the surviving ones
+        for(int y = 0; y < height; y++) for(int x = 0; x < width; x++) {
+            size_t i = (size_t)y * stride + x + 1;
+            
+            unsigned char col = 0;
+            if(cells_current[i]) col = (generation == 0 || cells_previous[i]) ? COLOR_MAX : COLOR_MID;
+            
+            cells_out[(size_t)y * width + x] = col;
+        }
+    }
+};
+
+#endif /* engine_tiled_h */
@@ -0,0 +1,45 @@
+//
+//  engines.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef engines_h
+#define engines_h
+
+// include the standard libraries
+#include <string>
+#include <iostream>
+
+#include "engine.h"
+#include "engine_cpu.h"
+#include "engine_bitpacked.h"
+#include "engine_simd.h"
+#include "engine_tiled.h"
+#include "engine_hashlife.h"
+#include "engine_ltl.h"
+#include "engine_lenia.h"
+
+// create one of the backends that do not need an OpenGL context
+inline Engine* createEngine(const std::string& engine_name, unsigned int threads_num = 0) {
+    if(engine_name == "cpu") return new EngineCPU(threads_num);
+    if(engine_name == "bitpacked") return new EngineBitPacked(threads_num);
+    if(engine_name == "simd") return new EngineSIMD(threads_num);
+    if(engine_name == "tiled") return new EngineTiled(threads_num);
+    if(engine_name == "hashlife") return new EngineHashLife();
+    if(engine_name == "hashlife-plane") return new EngineHashLife(true);
+    if(engine_name == "ltl") return new EngineLtL(threads_num);
+    if(engine_name == "lenia") return new EngineLenia(threads_num);
+    
+    // the SIMD engine forced to a given instruction set, used for verification
+    for(SIMDLevel level : {SIMD_SCALAR, SIMD_SSE42, SIMD_AVX2, SIMD_AVX512}) {
+        if(engine_name == std::string("simd-") + simdLevelName(level)) return new EngineSIMD(threads_num, level);
+    }
+    
+    std::cerr << "ERROR: ENGINE: UNKNOWN ENGINE: " << engine_name << std::endl;
+    exit(-1);
+}
+
+#endif /* engines_h */
@@ -0,0 +1,108 @@
+//
+//  ensemble.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef ensemble_h
+#define ensemble_h
+
+// include the standard libraries
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <iostream>
+
+#include "engine.h"
+#include "engines.h"
+
+// many independent boards of the same size stepped together, every board with its own rule - used for the parameter sweeps over small soups
+// the boards are packed one after another, board b starts at cells[b * width * height]
+class Ensemble {
+public:
+    int width, height, boards_num;
+    unsigned long long generation;
+    
+    Ensemble() : width(0), height(0), boards_num(0), generation(0) {}
+    virtual ~Ensemble() {}
+    
+    virtual const char* name() const = 0;
+    
+    // load boards_num_u boards of size width_u x height_u, rules[b] is the rule of the board b
+    virtual void load(const unsigned char* cells, const Rule* rules, int width_u, int height_u, int boards_num_u) = 0;
+    
+    virtual void step(unsigned int generations = 1) = 0;
+    
+    // read back all the boards, with the values of Engine::read()
+    virtual void read(unsigned char* cells) = 0;
+};
+
+// a random soup reproducible from its seed, every cell alive with the probability density
+// the soup can be generated in parts: the rows from first_cell / width on are the same as in the soup of the whole board
+inline void ensembleSoup(unsigned char* cells, int width, int height, uint64_t seed, float density, uint64_t first_cell = 0) {
+    uint64_t state = seed + first_cell * 0x9E3779B97F4A7C15ULL;
+    uint32_t threshold = (uint32_t)(density * 4294967295.0f);
+    
+    for(size_t i = 0; i < (size_t)width * height; i++) {
+        // splitmix64, so that the neighbouring seeds give unrelated soups
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        
+        cells[i] = (uint32_t)(z >> 32) < threshold ? 1 : 0;
+    }
+}
+
+// the batched mode of the CPU backends: one single-threaded engine per board, the boards are split between the threads
+// a board runs all its generations at once, there is no barrier between the boards
+class EnsembleCPU : public Ensemble {
+private:
+    std::string engine_name;
+    StripPool strips;
+    std::vector<std::unique_ptr<Engine>> engines;
+
+public:
+    EnsembleCPU(const std::string& engine_name_u, unsigned int threads_num_u = 0) : engine_name(engine_name_u), strips(defaultThreadsNum(threads_num_u)) {
+        // the tiled engine runs its own pool of threads, one pool per board would not fit
+        if(engine_name == "tiled") {
+            std::cerr << "ERROR: ENSEMBLE: THE tiled ENGINE CANNOT RUN IN AN ENSEMBLE, USE cpu, bitpacked OR simd" << std::endl;
+            exit(-1);
+        }
+    }
+    
+    const char* name() const {
+        return engine_name.c_str();
+    }
+    
+    void load(const unsigned char* cells, const Rule* rules, int width_u, int height_u, int boards_num_u) {
+        width = width_u;
+        height = height_u;
+        boards_num = boards_num_u;
+        generation = 0;
+        
+        engines.clear();
+        for(int b = 0; b < boards_num; b++) {
+            engines.emplace_back(createEngine(engine_name, 1));
+            engines[b]->setRule(rules[b]);
+            engines[b]->load(cells + (size_t)b * width * height, width, height);
+        }
+    }
+    
+    void step(unsigned int generations = 1) {
+        strips.run(boards_num, [this, generations](int board_begin, int board_end) {
+            for(int b = board_begin; b < board_end; b++) engines[b]->step(generations);
+        });
+        
+        generation += generations;
+    }
+    
+    void read(unsigned char* cells) {
+        for(int b = 0; b < boards_num; b++) engines[b]->read(cells + (size_t)b * width * height);
+    }
+};
+
+#endif /* ensemble_h */
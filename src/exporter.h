@@ -0,0 +1,166 @@
+//
+//  exporter.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef exporter_h
+#define exporter_h
+
+// include the standard libraries
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <sys/stat.h>
+
+// include the STB library to write the images
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include "engine.h"
+#include "engine_cpu.h"
+#include "thread_pool.h"
+
+#define EXPORT_QUEUE_MAX 16 // frames waiting for the encoders, the simulation waits when they fall this far behind
+
+// the part of the board shown, in the terms of the uniforms the Camera passes to automata.vs - the whole board by default
+struct ExportView {
+    float pos_x, pos_y;
+    float width_inv, height_inv;
+    
+    ExportView(float pos_x_u = 0.0f, float pos_y_u = 0.0f, float width_inv_u = 1.0f, float height_inv_u = 1.0f) : pos_x(pos_x_u), pos_y(pos_y_u), width_inv(width_inv_u), height_inv(height_inv_u) {}
+};
+
+// the view of the cells [x, x + region_width) x [y, y + region_height) of the board
+inline ExportView exportRegion(int x, int y, int region_width, int region_height, int width, int height) {
+    return ExportView(0.5f - (x + 0.5f * region_width) / width, 0.5f - (y + 0.5f * region_height) / height, (float)region_width / width, (float)region_height / height);
+}
+
+// the colour of a cell as automata.fs draws it: grey by the value read from the engine, the dying states of the Generations rules fading from orange to dark blue
+inline void exportColour(unsigned char cell, unsigned char state, int states, unsigned char* rgb) {
+    if(states > 2 && state >= 2) {
+        float t = (float)(state - 2) / (float)std::max(states - 3, 1);
+        rgb[0] = (unsigned char)((1.0f + (0.1f - 1.0f) * t) * 255.0f);
+        rgb[1] = (unsigned char)((0.5f - 0.5f * t) * 255.0f);
+        rgb[2] = (unsigned char)(0.3f * t * 255.0f);
+    } else {
+        rgb[0] = rgb[1] = rgb[2] = cell;
+    }
+}
+
+// sample the board for every pixel of the image like the renderer does: nearest cell, the board repeating around the view
+inline void exportImage(const unsigned char* cells, const unsigned char* states, int width, int height, int states_num, const ExportView& view, int image_width, int image_height, unsigned char* rgb) {
+    for(int j = 0; j < image_height; j++) {
+        float v = 0.5f + ((j + 0.5f) / image_height - 0.5f) * view.height_inv - view.pos_y;
+        int y = (int)std::floor(v * height) % height;
+        if(y < 0) y += height;
+        
+        for(int i = 0; i < image_width; i++) {
+            float u = 0.5f + ((i + 0.5f) / image_width - 0.5f) * view.width_inv - view.pos_x;
+            int x = (int)std::floor(u * width) % width;
+            if(x < 0) x += width;
+            
+            size_t cell = (size_t)y * width + x;
+            exportColour(cells[cell], states ? states[cell] : 0, states_num, rgb + 3 * ((size_t)j * image_width + i));
+        }
+    }
+}
+
+// exports frames of a run without a window: the simulation thread reads the board and maps it to an image, the PNG encoding runs on a pool of workers
+// at most EXPORT_QUEUE_MAX frames wait for the encoders, a frame submitted beyond that waits for one of them to finish
+class Exporter {
+private:
+    std::string directory;
+    ExportView view;
+    int image_width, image_height; // the size of the board when 0
+    
+    ThreadPool pool;
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t frames_queued;
+    unsigned long long frames_written;
+    bool failed;
+    
+    std::vector<unsigned char> cells, states; // the boards read from the engine, reused for every frame
+    double wait_time;
+
+public:
+    Exporter(const std::string& directory_u, unsigned int threads_num, const ExportView& view_u = ExportView(), int image_width_u = 0, int image_height_u = 0) : directory(directory_u), view(view_u), image_width(image_width_u), image_height(image_height_u), pool(defaultThreadsNum(threads_num)), frames_queued(0), frames_written(0), failed(false), wait_time(0.0) {
+        mkdir(directory.c_str(), 0755); // fails harmlessly when it exists
+    }
+    
+    ~Exporter() {
+        wait();
+    }
+    
+    // read the board of the engine and queue its image, named after the generation
+    void submit(Engine& engine, unsigned long long generation) {
+        {
+            auto wait_start = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return frames_queued < EXPORT_QUEUE_MAX; });
+            frames_queued++;
+            wait_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start).count();
+        }
+        
+        cells.resize((size_t)engine.width * engine.height);
+        engine.read(cells.data());
+        
+        // only the cpu engine keeps the dying states of the Generations rules
+        EngineCPU* engine_cpu = dynamic_cast<EngineCPU*>(&engine);
+        bool with_states = engine.rule.states > 2 && engine_cpu;
+        if(with_states) {
+            states.resize(cells.size());
+            engine_cpu->readStates(states.data());
+        }
+        
+        int frame_width = image_width > 0 ? image_width : engine.width;
+        int frame_height = image_height > 0 ? image_height : engine.height;
+        std::shared_ptr<std::vector<unsigned char>> rgb(new std::vector<unsigned char>(3 * (size_t)frame_width * frame_height));
+        exportImage(cells.data(), with_states ? states.data() : nullptr, engine.width, engine.height, (int)engine.rule.states, view, frame_width, frame_height, rgb->data());
+        
+        char name[32];
+        snprintf(name, sizeof(name), "/frame_%09llu.png", generation);
+        std::string path = directory + name;
+        
+        pool.submit([this, rgb, path, frame_width, frame_height] {
+            bool written = stbi_write_png(path.c_str(), frame_width, frame_height, 3, rgb->data(), 3 * frame_width) != 0;
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            if(written) frames_written++;
+            else failed = true;
+            frames_queued--;
+            condition.notify_all();
+        });
+    }
+    
+    // block until every queued frame is written
+    void wait() {
+        pool.wait();
+        
+        if(failed) {
+            std::cerr << "ERROR: EXPORTER: SOME FRAMES COULD NOT BE WRITTEN TO: " << directory << std::endl;
+            failed = false;
+        }
+    }
+    
+    unsigned long long framesWritten() const {
+        return frames_written;
+    }
+    
+    // the time the simulation spent waiting for the encoders
+    double waitTime() const {
+        return wait_time;
+    }
+};
+
+#endif /* exporter_h */
@@ -0,0 +1,181 @@
+//
+//  fft.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef fft_h
+#define fft_h
+
+// include the standard libraries
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+
+#include "engine.h"
+
+typedef std::complex<float> Complex;
+
+#define FFT_COLUMNS_BLOCK 8 // columns gathered at once, 8 complex numbers fill a cache line
+
+inline bool fftPowerOfTwo(int n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+// chirp[j] = exp(-i pi j^2 / n) of Bluestein's algorithm, j^2 is reduced modulo 2n so that the angle stays accurate for long lines
+inline std::vector<Complex> fftChirp(int n) {
+    std::vector<Complex> chirp(n);
+    for(int j = 0; j < n; j++) {
+        double angle = M_PI * (double)(((long long)j * j) % (2LL * n)) / n;
+        chirp[j] = Complex((float)cos(angle), (float)-sin(angle));
+    }
+    return chirp;
+}
+
+// unnormalised 1D discrete Fourier transform of length n, O(n log n) for any n
+// the powers of two go through the iterative radix-2 algorithm, the other lengths through Bluestein's algorithm, which turns the transform into
+// a circular convolution of length m >= 2n - 1 (a power of two) with a chirp
+class FFT {
+private:
+    int n, m; // m is the length of the radix-2 transform, n when n is a power of two
+    std::vector<int> reversed; // bit-reversed indices of the radix-2 transform
+    std::vector<Complex> twiddles; // exp(-2 pi i k / m), k < m / 2
+    std::vector<Complex> chirp, chirp_spectrum; // Bluestein's algorithm: the chirp and the transform of its conjugate, wrapped around to length m
+    
+    void radix2(Complex* data, bool inverse) const {
+        for(int i = 0; i < m; i++) if(i < reversed[i]) std::swap(data[i], data[reversed[i]]);
+        
+        for(int length = 2; length <= m; length <<= 1) {
+            int half = length >> 1, step = m / length;
+            
+            for(int begin = 0; begin < m; begin += length) for(int k = 0; k < half; k++) {
+                // the product spelled out, std::complex checks for the infinities on every multiplication
+                float twiddle_re = twiddles[k * step].real(), twiddle_im = inverse ? -twiddles[k * step].imag() : twiddles[k * step].imag();
+                Complex even = data[begin + k], odd = data[begin + k + half];
+                Complex odd_twiddled(odd.real() * twiddle_re - odd.imag() * twiddle_im, odd.real() * twiddle_im + odd.imag() * twiddle_re);
+                data[begin + k] = even + odd_twiddled;
+                data[begin + k + half] = even - odd_twiddled;
+            }
+        }
+    }
+
+public:
+    FFT(int n_u = 1) : n(n_u) {
+        m = 1;
+        while(m < (fftPowerOfTwo(n) ? n : 2 * n - 1)) m <<= 1;
+        
+        int bits = 0;
+        while((1 << bits) < m) bits++;
+        
+        reversed.resize(m);
+        for(int i = 0; i < m; i++) {
+            reversed[i] = 0;
+            for(int b = 0; b < bits; b++) if((i >> b) & 1) reversed[i] |= 1 << (bits - 1 - b);
+        }
+        
+        twiddles.resize(std::max(1, m / 2));
+        for(int k = 0; k < m / 2; k++) twiddles[k] = Complex((float)cos(2.0 * M_PI * k / m), (float)-sin(2.0 * M_PI * k / m));
+        
+        if(m != n) {
+            chirp = fftChirp(n);
+            
+            // the conjugate chirp is symmetric, b[m - j] = b[j], so the transform for the inverse direction is the conjugate of this one
+            chirp_spectrum.assign(m, Complex(0.0f, 0.0f));
+            for(int j = 0; j < n; j++) {
+                chirp_spectrum[j] = std::conj(chirp[j]);
+                if(j > 0) chirp_spectrum[m - j] = std::conj(chirp[j]);
+            }
+            radix2(chirp_spectrum.data(), false);
+        }
+    }
+    
+    int size() const {
+        return n;
+    }
+    
+    // length of the scratch buffer passed to transform()
+    int scratchSize() const {
+        return m;
+    }
+    
+    const std::vector<Complex>& chirpValues() const {
+        return chirp;
+    }
+    
+    const std::vector<Complex>& chirpSpectrum() const {
+        return chirp_spectrum;
+    }
+    
+    // transform the elements data[0], data[stride], ... data[(n - 1) * stride] in place, the inverse transform is not divided by n
+    void transform(Complex* data, size_t stride, bool inverse, std::vector<Complex>& scratch) const {
+        scratch.resize(m);
+        
+        if(m == n) {
+            for(int j = 0; j < n; j++) scratch[j] = data[j * stride];
+            radix2(scratch.data(), inverse);
+            for(int j = 0; j < n; j++) data[j * stride] = scratch[j];
+            return;
+        }
+        
+        // X[k] = chirp[k] * sum_j (x[j] * chirp[j]) * conj(chirp[k - j]), conjugated chirps for the inverse
+        for(int j = 0; j < n; j++) scratch[j] = data[j * stride] * (inverse ? std::conj(chirp[j]) : chirp[j]);
+        std::fill(scratch.begin() + n, scratch.end(), Complex(0.0f, 0.0f));
+        
+        radix2(scratch.data(), false);
+        float scale = 1.0f / m;
+        for(int j = 0; j < m; j++) scratch[j] *= (inverse ? std::conj(chirp_spectrum[j]) : chirp_spectrum[j]) * scale;
+        radix2(scratch.data(), true);
+        
+        for(int k = 0; k < n; k++) data[k * stride] = scratch[k] * (inverse ? std::conj(chirp[k]) : chirp[k]);
+    }
+};
+
+// 2D transform of a width x height row-major board, the rows and then the columns in strips
+class FFT2D {
+private:
+    int width, height;
+    FFT fft_rows, fft_cols;
+    
+    void transformRows(Complex* data, int y_begin, int y_end, bool inverse) const {
+        std::vector<Complex> scratch;
+        for(int y = y_begin; y < y_end; y++) fft_rows.transform(&data[(size_t)y * width], 1, inverse, scratch);
+    }
+    
+    void transformCols(Complex* data, int block_begin, int block_end, bool inverse) const {
+        // gather blocks of columns into contiguous lines, so that every row is read a cache line at a time
+        std::vector<Complex> lines((size_t)FFT_COLUMNS_BLOCK * height), scratch;
+        
+        for(int block = block_begin; block < block_end; block++) {
+            int x_begin = block * FFT_COLUMNS_BLOCK;
+            int x_end = std::min(width, x_begin + FFT_COLUMNS_BLOCK);
+            
+            for(int y = 0; y < height; y++) for(int x = x_begin; x < x_end; x++) lines[(size_t)(x - x_begin) * height + y] = data[(size_t)y * width + x];
+            for(int x = x_begin; x < x_end; x++) fft_cols.transform(&lines[(size_t)(x - x_begin) * height], 1, inverse, scratch);
+            for(int y = 0; y < height; y++) for(int x = x_begin; x < x_end; x++) data[(size_t)y * width + x] = lines[(size_t)(x - x_begin) * height + y];
+        }
+    }
+
+public:
+    FFT2D(int width_u = 1, int height_u = 1) : width(width_u), height(height_u), fft_rows(width_u), fft_cols(height_u) {}
+    
+    const FFT& rows() const {
+        return fft_rows;
+    }
+    
+    const FFT& cols() const {
+        return fft_cols;
+    }
+    
+    // the inverse transform is not divided by width * height
+    void transform(Complex* data, bool inverse, StripPool& strips) const {
+        int blocks_num = (width + FFT_COLUMNS_BLOCK - 1) / FFT_COLUMNS_BLOCK;
+        
+        strips.run(height, [this, data, inverse](int y_begin, int y_end) { transformRows(data, y_begin, y_end, inverse); });
+        strips.run(blocks_num, [this, data, inverse](int block_begin, int block_end) { transformCols(data, block_begin, block_end, inverse); });
+    }
+};
+
+#endif /* fft_h */
@@ -0,0 +1,36 @@
+//
+//  image.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef image_h
+#define image_h
+
+// include the standard libraries
+#include <vector>
+#include <iostream>
+
+// include the STB library to read texture files
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+// load the initial state from a texture file without going through OpenGL - a cell is alive when its red channel is lit, as in processTexture
+inline void loadImageState(const char* texture_path, std::vector<unsigned char>& cells, int& width, int& height) {
+    int channels_num;
+    unsigned char* texture_data = stbi_load(texture_path, &width, &height, &channels_num, 4);
+    
+    if(!texture_data) {
+        std::cerr << "ERROR: STBI: Texture failed to load at path: " << texture_path << std::endl;
+        exit(-1);
+    }
+    
+    cells.resize((size_t)width * height);
+    for(size_t i = 0; i < cells.size(); i++) cells[i] = texture_data[4 * i] > 0 ? 1 : 0;
+    
+    stbi_image_free(texture_data);
+}
+
+#endif /* image_h */
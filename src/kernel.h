@@ -14,6 +14,10 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <map>
+#include <chrono>
+#include <mutex>
 
 // include the OpenCL library (C++ binding)
 #define __CL_ENABLE_EXCEPTIONS
@@ -26,13 +30,18 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-// include the STB library to read texture files
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
+#include "image.h"
 #include "shader.h"
+#include "camera.h"
+#include "engine.h"
+#include "fft.h"
+#include "kernel_fft.h"
+#include "metrics.h"
+#include "program_cache.h"
+
+#define CL_TILE_SIZE 16 // side of the tiles of the active-region tracking, passed to the kernels as TILE_SIZE
 
-class KernelGL {
+class KernelGL : public Engine {
 private:
     class ImageGLObj {
     private:
@@ -98,13 +107,13 @@ private:
         
         ImageGLObj() {}
         
-        ImageGLObj(const char* texture_path, const char* kernel_name, cl::Device& device, cl::Context& context, cl::Program& program) {
+        ImageGLObj(const char* texture_path, const char* kernel_name, cl::CommandQueue& queue, cl::Context& context, cl::Program& program) {
             generateGLTextureFromFile(texture_path);
             cl_GLuint texture_file_ID = texture_ID;
             generateGLTexture();
             
             cl::ImageGL textureImage(context, CL_MEM_READ_ONLY, GL_TEXTURE_2D, 0, texture_file_ID);
-            image_GL = cl::ImageGL(context, CL_MEM_WRITE_ONLY, GL_TEXTURE_2D, 0, texture_ID);
+            image_GL = cl::ImageGL(context, CL_MEM_READ_WRITE, GL_TEXTURE_2D, 0, texture_ID);
             
             // create the kernel to process the initial texture
             
@@ -117,7 +126,6 @@ private:
             
             // process the initial texture
             
-            cl::CommandQueue queue(context, device);
             queue.enqueueNDRangeKernel(processing_kernel, cl::NullRange, cl::NDRange(size_t(width), size_t(height)), cl::NullRange);
             queue.finish();
             
@@ -126,6 +134,41 @@ private:
             glDeleteTextures(1, &texture_file_ID);
         }
         
+        ImageGLObj(const unsigned char* cells, int width_u, int height_u, cl::Context& context) {
+            width = width_u;
+            height = height_u;
+            
+            generateGLTexture();
+            
+            // upload the cells straight into the state texture, no processing pass needed
+            
+            std::vector<unsigned char> texture_data(4 * (size_t)width * height);
+            for(size_t i = 0; i < (size_t)width * height; i++) {
+                unsigned char col = cells[i] > 0 ? COLOR_MAX : 0;
+                texture_data[4 * i] = col;
+                texture_data[4 * i + 1] = col;
+                texture_data[4 * i + 2] = col;
+                texture_data[4 * i + 3] = 1;
+            }
+            
+            glBindTexture(GL_TEXTURE_2D, texture_ID);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, texture_data.data());
+            glFinish();
+            
+            image_GL = cl::ImageGL(context, CL_MEM_READ_WRITE, GL_TEXTURE_2D, 0, texture_ID);
+        }
+        
+        ImageGLObj(int width_u, int height_u, cl::Context& context) {
+            width = width_u;
+            height = height_u;
+            
+            // an empty state texture, filled by the first iteration that writes to it
+            
+            generateGLTexture();
+            
+            image_GL = cl::ImageGL(context, CL_MEM_READ_WRITE, GL_TEXTURE_2D, 0, texture_ID);
+        }
+        
         void setKernelArg(cl::Kernel& kernel, int kernel_pos) {
             kernel.setArg(kernel_pos, image_GL);
         }
@@ -143,10 +186,78 @@ private:
     cl::Device device;
     cl::Context context;
     cl::Program program;
-    cl::Kernel kernel;
+    cl::Kernel kernels[2];
+    std::string kernel_name_iterate;
+    
+    // the programs built so far, one per rule - the rule is compiled into the kernels
+    std::string kernel_source;
+    std::map<std::string, cl::Program> programs;
+    ProgramCache program_cache; // and the binaries of the programs built by the previous runs
+    
+    // the queue is created once, the iterations are chained on it without blocking the host
+    cl::CommandQueue queue;
+    std::vector<cl::Memory> mem_objs;
+    cl::Event iteration_event;
+    bool iteration_pending;
+    
+    // the queue is profiled, the acquire and the release events of the iterations not yet recorded wait here until the iterations are done
+    Metrics* metrics;
+    std::vector<std::pair<cl::Event, cl::Event>> profiled_iterations;
+    
+    // ping-pong state images: images[current] holds the newest generation, the next one is written to the other image
+    // every kernel comes in a pair, one for each direction, so that their arguments are set only once
+    ImageGLObj images[2];
+    int current;
+    
+    // active-region tracking: tiles_changed[current] flags the tiles changed by the last generation
+    bool active_tracking;
+    cl::Kernel compact_kernels[2], active_kernels[2];
+    cl::Buffer tiles_changed[2], tiles_active, tiles_active_num;
+    int tiles_x, tiles_y;
+    bool tiles_stale; // the blocked launches do not track the changes, the flags have to be reset before the next tracked one
     
-    cl::Image2D image_in;
-    ImageGLObj image_out;
+    // temporal blocking: generations advanced by a single launch of the kernel iterating in local memory
+    cl::Kernel blocked_kernels[2];
+    unsigned int generations_per_launch;
+    
+    // Larger-than-Life: the counts come from a summed-area table rebuilt every generation
+    bool ltl_enabled;
+    RuleLtL rule_ltl;
+    cl::Kernel ltl_fill_kernels[2], ltl_scan_rows_kernel, ltl_scan_cols_kernel, ltl_kernels[2];
+    cl::Buffer ltl_sums;
+    int ltl_sums_width, ltl_sums_height;
+    
+    // Generations rules: the transitions of all the states in one table, looked up once per cell
+    cl::Kernel generations_kernels[2];
+    cl::Buffer generations_transitions;
+    
+    // Lenia: the states stay in a float buffer, the potential is the product of the transforms of the board and of the kernel of the rule
+    bool lenia_enabled;
+    RuleLenia rule_lenia;
+    FFTCL fft;
+    cl::Kernel lenia_load_kernel, lenia_fill_kernel, lenia_multiply_kernel, lenia_kernels[2];
+    cl::Buffer lenia_cells, lenia_spectrum[2], lenia_weights_spectrum;
+    
+    // the density pyramid of the zoomed-out views: density_levels[l - 1] holds level l, a texel per 2^l x 2^l cells
+    // a frame builds only the levels up to the one it shows and only over the part of the board in view, density_key is what the last build covered
+    struct DensityLevel {
+        GLuint texture_ID;
+        cl::ImageGL image_GL;
+        int width, height;
+    };
+    std::vector<DensityLevel> density_levels;
+    cl::Kernel reduce_cells_kernel, reduce_density_kernel;
+    std::vector<long long> density_key;
+    
+    // decoupled rendering: the simulation thread copies every generation it publishes into one of three display images and the renderer samples the newest of them
+    // display_back is written next, display_front holds the newest generation published and display_drawn the one drawn - display_fresh when front is newer than drawn
+    bool decoupled;
+    ImageGLObj display_images[3];
+    unsigned long long display_generations[3];
+    int display_back, display_front, display_drawn;
+    bool display_fresh;
+    std::mutex display_mutex;
+    cl::CommandQueue render_queue; // the renderer builds the density pyramid on a queue of its own, not behind the iterations
     
     
     void processError(cl::Error& e) {
@@ -178,9 +289,7 @@ private:
         return kernel_code;
     }
     
-    void buildProgram(const char* kernel_path) {
-        // build the program given the source
-        
+    void createContext() {
         std::vector<cl::Platform> platforms;
         std::vector<cl::Device> devices;
         
@@ -188,7 +297,8 @@ private:
         
         cl::Platform::get(&platforms);
         if(platforms.size() == 0) {
-            std::cerr << "ERROR: OpenCL: NO PLATFORMS FOUND" << std::endl;;
+            std::cerr << "ERROR: OpenCL: NO PLATFORMS FOUND" << std::endl;
+            exit(-1);
         }
         
         // find device
@@ -196,9 +306,11 @@ private:
         platforms[0].getDevices(CL_DEVICE_TYPE_GPU, &devices);
         if(devices.size() == 0) {
             std::cerr << "ERROR: OpenCL: NO DEVICES FOUND" << std::endl;
+            exit(-1);
         }
         
-        device = devices[1]; //choose the graphics card
+        // the OpenGL context shares its textures with a single device, the other devices are used by KernelMulti
+        device = devices[devices.size() > 1 ? 1 : 0]; //choose the graphics card
         std::cout << "SUCCESS: OpenCL: USING A DEVICE: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
         
         // create shared context between OpenCL and OpenGL - therefore no communication via host needed!
@@ -215,37 +327,451 @@ private:
         };
         
         context = cl::Context(device, properties);
+        queue = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE);
+        render_queue = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE);
+    }
+    
+    static double eventSeconds(cl_ulong begin, cl_ulong end) {
+        return (end - begin) * 1e-9;
+    }
+    
+    // the kernels of an iteration run between the end of the acquire and the start of the release, whatever their number
+    void recordIterations() {
+        for(const auto& events : profiled_iterations) {
+            const cl::Event& acquire_event = events.first;
+            const cl::Event& release_event = events.second;
+            
+            metrics->record("cl_acquire", eventSeconds(acquire_event.getProfilingInfo<CL_PROFILING_COMMAND_START>(), acquire_event.getProfilingInfo<CL_PROFILING_COMMAND_END>()));
+            metrics->record("cl_iterate", eventSeconds(acquire_event.getProfilingInfo<CL_PROFILING_COMMAND_END>(), release_event.getProfilingInfo<CL_PROFILING_COMMAND_START>()));
+            metrics->record("cl_release", eventSeconds(release_event.getProfilingInfo<CL_PROFILING_COMMAND_START>(), release_event.getProfilingInfo<CL_PROFILING_COMMAND_END>()));
+        }
+        profiled_iterations.clear();
+    }
+    
+    void buildProgram() {
+        // build the program for the current rule, or take the one built before
+        
+        std::string rule_string = ruleString(rule);
         
-        // upload program source
+        auto program_found = programs.find(rule_string);
+        if(program_found != programs.end()) {
+            program = program_found->second;
+            return;
+        }
+        
+        // build the program, the rule masks become constants of the kernels
         
-        std::string kernel_code = loadSource(kernel_path);
-        cl::Program::Sources sources;
-        sources.push_back({kernel_code.c_str(), kernel_code.length()});
+        std::string options = "-D TILE_SIZE=" + std::to_string(CL_TILE_SIZE);
+        options += " -D RULE_BIRTH=" + std::to_string(rule.birth) + "u";
+        options += " -D RULE_SURVIVAL=" + std::to_string(rule.survival) + "u";
+        options += " -D RULE_STATES=" + std::to_string(rule.states) + "u";
         
-        // build the program
+        program_cache.build(program, context, device, kernel_source, options);
         
-        program = cl::Program(context, sources);
-        program.build({device});
+        programs[rule_string] = program;
     }
     
-    void createKernel(const char* kernel_name) {
+    void createKernel() {
         // create the kernel given the name
         
-        kernel = cl::Kernel(program, kernel_name);
+        for(int i = 0; i < 2; i++) {
+            kernels[i] = cl::Kernel(program, kernel_name_iterate.c_str());
+            compact_kernels[i] = cl::Kernel(program, "compactTiles");
+            active_kernels[i] = cl::Kernel(program, "iterateActive");
+            blocked_kernels[i] = cl::Kernel(program, "iterateBlocked");
+            ltl_fill_kernels[i] = cl::Kernel(program, "ltlFill");
+            ltl_kernels[i] = cl::Kernel(program, "ltlIterate");
+            generations_kernels[i] = cl::Kernel(program, "iterateGenerations");
+            lenia_kernels[i] = cl::Kernel(program, "leniaIterate");
+        }
+        ltl_scan_rows_kernel = cl::Kernel(program, "ltlScanRows");
+        ltl_scan_cols_kernel = cl::Kernel(program, "ltlScanCols");
+        lenia_load_kernel = cl::Kernel(program, "leniaLoad");
+        lenia_fill_kernel = cl::Kernel(program, "leniaFill");
+        lenia_multiply_kernel = cl::Kernel(program, "leniaMultiply");
+        reduce_cells_kernel = cl::Kernel(program, "reduceCells");
+        reduce_density_kernel = cl::Kernel(program, "reduceDensity");
+        fft.createKernels(program);
     }
     
     void setKernelArgs() {
-        kernel.setArg(0, image_in);
-        image_out.setKernelArg(kernel, 1);
+        for(int i = 0; i < 2; i++) {
+            images[i].setKernelArg(kernels[i], 0);
+            images[1 - i].setKernelArg(kernels[i], 1);
+        
+            cl::Buffer& changed = tiles_changed[i];
+            cl::Buffer& changed_next = tiles_changed[1 - i];
+            
+            compact_kernels[i].setArg(0, changed);
+            compact_kernels[i].setArg(1, changed_next);
+            compact_kernels[i].setArg(2, tiles_active);
+            compact_kernels[i].setArg(3, tiles_active_num);
+            compact_kernels[i].setArg(4, tiles_x);
+            compact_kernels[i].setArg(5, tiles_y);
+            
+            images[i].setKernelArg(active_kernels[i], 0);
+            images[1 - i].setKernelArg(active_kernels[i], 1);
+            active_kernels[i].setArg(2, tiles_active);
+            active_kernels[i].setArg(3, tiles_active_num);
+            active_kernels[i].setArg(4, changed_next);
+            active_kernels[i].setArg(5, tiles_x);
+            
+            images[i].setKernelArg(blocked_kernels[i], 0);
+            images[1 - i].setKernelArg(blocked_kernels[i], 1);
+            
+            images[i].setKernelArg(generations_kernels[i], 0);
+            images[1 - i].setKernelArg(generations_kernels[i], 1);
+            generations_kernels[i].setArg(2, generations_transitions);
+        }
+        
+        // the GL objects shared with OpenCL do not change between the iterations either
+        
+        mem_objs.clear();
+        for(int i = 0; i < 2; i++) mem_objs.push_back(images[i].image_GL);
+        
+        if(ltl_enabled) createLtL();
+        if(lenia_enabled) createLenia();
     }
     
-public:
-    int width, height;
+    void createLtL() {
+        // the table covers the board with a margin of R cells, rotated by 45 degrees for the von Neumann neighbourhood
+        
+        int padded_width = width + 2 * rule_ltl.radius;
+        int padded_height = height + 2 * rule_ltl.radius;
+        
+        if(rule_ltl.von_neumann) {
+            ltl_sums_width = padded_width + padded_height;
+            ltl_sums_height = padded_width + padded_height;
+        } else {
+            ltl_sums_width = padded_width + 1;
+            ltl_sums_height = padded_height + 1;
+        }
+        
+        size_t sums_size = (size_t)ltl_sums_width * ltl_sums_height * sizeof(cl_int);
+        ltl_sums = cl::Buffer(context, CL_MEM_READ_WRITE, sums_size);
+        queue.enqueueFillBuffer(ltl_sums, (cl_int)0, 0, sums_size);
+        
+        for(int i = 0; i < 2; i++) {
+            images[i].setKernelArg(ltl_fill_kernels[i], 0);
+            ltl_fill_kernels[i].setArg(1, ltl_sums);
+            ltl_fill_kernels[i].setArg(2, ltl_sums_width);
+            ltl_fill_kernels[i].setArg(3, rule_ltl.radius);
+            ltl_fill_kernels[i].setArg(4, (cl_int)rule_ltl.von_neumann);
+            
+            images[i].setKernelArg(ltl_kernels[i], 0);
+            images[1 - i].setKernelArg(ltl_kernels[i], 1);
+            ltl_kernels[i].setArg(2, ltl_sums);
+            ltl_kernels[i].setArg(3, ltl_sums_width);
+            ltl_kernels[i].setArg(4, rule_ltl.radius);
+            ltl_kernels[i].setArg(5, (cl_int)rule_ltl.von_neumann);
+            ltl_kernels[i].setArg(6, (cl_int)rule_ltl.centre);
+            ltl_kernels[i].setArg(7, rule_ltl.birth_min);
+            ltl_kernels[i].setArg(8, rule_ltl.birth_max);
+            ltl_kernels[i].setArg(9, rule_ltl.survival_min);
+            ltl_kernels[i].setArg(10, rule_ltl.survival_max);
+        }
+        
+        ltl_scan_rows_kernel.setArg(0, ltl_sums);
+        ltl_scan_rows_kernel.setArg(1, ltl_sums_width);
+        
+        ltl_scan_cols_kernel.setArg(0, ltl_sums);
+        ltl_scan_cols_kernel.setArg(1, ltl_sums_width);
+        ltl_scan_cols_kernel.setArg(2, ltl_sums_height);
+    }
+    
+    void createLenia() {
+        size_t cells_num = (size_t)width * height;
+        
+        fft.create(context, width, height);
+        
+        // the transform of the kernel is computed once, on the host
+        
+        std::vector<float> weights = leniaWeights(rule_lenia, width, height);
+        std::vector<Complex> weights_spectrum(cells_num);
+        float scale = 1.0f / cells_num;
+        for(size_t i = 0; i < cells_num; i++) weights_spectrum[i] = Complex(weights[i] * scale, 0.0f);
+        StripPool strips(defaultThreadsNum(0));
+        FFT2D(width, height).transform(weights_spectrum.data(), false, strips);
+        
+        lenia_weights_spectrum = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, cells_num * sizeof(cl_float2), weights_spectrum.data());
+        lenia_cells = cl::Buffer(context, CL_MEM_READ_WRITE, cells_num * sizeof(cl_float));
+        for(int i = 0; i < 2; i++) lenia_spectrum[i] = cl::Buffer(context, CL_MEM_READ_WRITE, cells_num * sizeof(cl_float2));
+        
+        // the states start from the current image
+        
+        images[current].setKernelArg(lenia_load_kernel, 0);
+        lenia_load_kernel.setArg(1, lenia_cells);
+        
+        queue.enqueueAcquireGLObjects(&mem_objs);
+        queue.enqueueNDRangeKernel(lenia_load_kernel, cl::NullRange, cl::NDRange(size_t(width), size_t(height)), cl::NullRange);
+        queue.enqueueReleaseGLObjects(&mem_objs);
+        queue.finish();
+        
+        lenia_fill_kernel.setArg(0, lenia_cells);
+        lenia_fill_kernel.setArg(1, lenia_spectrum[0]);
+        
+        lenia_multiply_kernel.setArg(1, lenia_weights_spectrum);
+        
+        for(int i = 0; i < 2; i++) {
+            images[1 - i].setKernelArg(lenia_kernels[i], 0);
+            lenia_kernels[i].setArg(1, lenia_cells);
+            lenia_kernels[i].setArg(3, rule_lenia.mu);
+            lenia_kernels[i].setArg(4, rule_lenia.sigma);
+            lenia_kernels[i].setArg(5, 1.0f / rule_lenia.time_steps);
+        }
+    }
+
+    void createTiles() {
+        tiles_x = (width + CL_TILE_SIZE - 1) / CL_TILE_SIZE;
+        tiles_y = (height + CL_TILE_SIZE - 1) / CL_TILE_SIZE;
+        
+        size_t tiles_num = (size_t)tiles_x * tiles_y;
+        
+        for(int i = 0; i < 2; i++) tiles_changed[i] = cl::Buffer(context, CL_MEM_READ_WRITE, tiles_num);
+        tiles_active = cl::Buffer(context, CL_MEM_READ_WRITE, tiles_num * sizeof(cl_int));
+        tiles_active_num = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_int));
+        
+        // every tile counts as changed before the first two generations, whatever the current image
+        
+        queue.enqueueFillBuffer(tiles_changed[0], (cl_uchar)1, 0, tiles_num);
+        queue.enqueueFillBuffer(tiles_changed[1], (cl_uchar)1, 0, tiles_num);
+        queue.finish();
+        
+        tiles_stale = false;
+    }
+    
+    void enqueueActiveTiles() {
+        // compact the tiles next to a changed tile into a work list, then step only the listed tiles
+        
+        if(tiles_stale) {
+            size_t tiles_num = (size_t)tiles_x * tiles_y;
+            queue.enqueueFillBuffer(tiles_changed[0], (cl_uchar)1, 0, tiles_num);
+            queue.enqueueFillBuffer(tiles_changed[1], (cl_uchar)1, 0, tiles_num);
+            tiles_stale = false;
+        }
+        
+        queue.enqueueFillBuffer(tiles_active_num, (cl_int)0, 0, sizeof(cl_int));
+        queue.enqueueNDRangeKernel(compact_kernels[current], cl::NullRange, cl::NDRange(size_t(tiles_x), size_t(tiles_y)), cl::NullRange);
+        queue.enqueueNDRangeKernel(active_kernels[current], cl::NullRange, cl::NDRange(CL_TILE_SIZE, CL_TILE_SIZE, size_t(tiles_x) * tiles_y), cl::NDRange(CL_TILE_SIZE, CL_TILE_SIZE, 1));
+    }
+        
+    void enqueueBlocked(unsigned int k) {
+        // one work-group per tile, the size of the local buffers follows k
+        
+        size_t side = CL_TILE_SIZE + 2 * k;
+        
+        cl::Kernel& blocked_kernel = blocked_kernels[current];
+        blocked_kernel.setArg(2, (cl_int)k);
+        blocked_kernel.setArg(3, cl::Local(side * side));
+        blocked_kernel.setArg(4, cl::Local(side * side));
+        
+        queue.enqueueNDRangeKernel(blocked_kernel, cl::NullRange, cl::NDRange(size_t(tiles_x) * CL_TILE_SIZE, size_t(tiles_y) * CL_TILE_SIZE), cl::NDRange(CL_TILE_SIZE, CL_TILE_SIZE));
+        
+        tiles_stale = true;
+    }
+    
+    void enqueueLtL() {
+        // the rotated board does not cover every entry of the table, the gaps have to be 0
+        if(rule_ltl.von_neumann) queue.enqueueFillBuffer(ltl_sums, (cl_int)0, 0, (size_t)ltl_sums_width * ltl_sums_height * sizeof(cl_int));
+        
+        queue.enqueueNDRangeKernel(ltl_fill_kernels[current], cl::NullRange, cl::NDRange(size_t(width + 2 * rule_ltl.radius), size_t(height + 2 * rule_ltl.radius)), cl::NullRange);
+        queue.enqueueNDRangeKernel(ltl_scan_rows_kernel, cl::NullRange, cl::NDRange(size_t(ltl_sums_height)), cl::NullRange);
+        queue.enqueueNDRangeKernel(ltl_scan_cols_kernel, cl::NullRange, cl::NDRange(size_t(ltl_sums_width)), cl::NullRange);
+        queue.enqueueNDRangeKernel(ltl_kernels[current], cl::NullRange, cl::NDRange(size_t(width), size_t(height)), cl::NullRange);
+        
+        tiles_stale = true;
+    }
+    
+    void enqueueLenia() {
+        // the buffer holding the transform depends on the number of the power-of-two passes
+        
+        int spectrum_current = 0;
+        
+        queue.enqueueNDRangeKernel(lenia_fill_kernel, cl::NullRange, cl::NDRange((size_t)width * height), cl::NullRange);
+        fft.enqueue(queue, lenia_spectrum, spectrum_current, false);
+        
+        lenia_multiply_kernel.setArg(0, lenia_spectrum[spectrum_current]);
+        queue.enqueueNDRangeKernel(lenia_multiply_kernel, cl::NullRange, cl::NDRange((size_t)width * height), cl::NullRange);
+        fft.enqueue(queue, lenia_spectrum, spectrum_current, true);
+        
+        lenia_kernels[current].setArg(2, lenia_spectrum[spectrum_current]);
+        queue.enqueueNDRangeKernel(lenia_kernels[current], cl::NullRange, cl::NDRange(size_t(width), size_t(height)), cl::NullRange);
+        
+        tiles_stale = true;
+    }
+    
+    void createTransitions() {
+        std::vector<unsigned char> transitions = ruleTransitions(rule);
+        generations_transitions = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, transitions.size(), transitions.data());
+    }
+    
+    // the Larger-than-Life, the Generations and the Lenia rules are not blocked
+    unsigned int launchGenerations() const {
+        return (ltl_enabled || lenia_enabled || rule.states > 2) ? 1 : generations_per_launch;
+    }
+    
+    void enqueueIteration(unsigned int k) {
+        // enqueue the iteration behind the previous one on the persistent queue and return straight away
+        // OpenGL has to flush its commands on the texture before this call
+        
+        cl::Event acquire_event;
+        queue.enqueueAcquireGLObjects(&mem_objs, NULL, &acquire_event);
+        if(lenia_enabled) enqueueLenia();
+        else if(ltl_enabled) enqueueLtL();
+        else if(rule.states > 2) {
+            queue.enqueueNDRangeKernel(generations_kernels[current], cl::NullRange, cl::NDRange(size_t(width), size_t(height)), cl::NullRange);
+            tiles_stale = true;
+        } else if(k > 1) enqueueBlocked(k);
+        else if(active_tracking) enqueueActiveTiles();
+        else queue.enqueueNDRangeKernel(kernels[current], cl::NullRange, cl::NDRange(size_t(width), size_t(height)), cl::NullRange);
+        queue.enqueueReleaseGLObjects(&mem_objs, NULL, &iteration_event);
+        queue.flush();
+        
+        if(metrics) profiled_iterations.push_back(std::make_pair(acquire_event, iteration_event));
+        
+        current = 1 - current;
+        iteration_pending = true;
+        generation += k;
+    }
+        
+    void createDensityLevels(int levels) {
+        while((int)density_levels.size() < levels) {
+            int level = (int)density_levels.size() + 1;
+            
+            DensityLevel density_level;
+            density_level.width = ((width - 1) >> level) + 1;
+            density_level.height = ((height - 1) >> level) + 1;
+            
+            glGenTextures(1, &density_level.texture_ID);
+            glBindTexture(GL_TEXTURE_2D, density_level.texture_ID);
+            
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, density_level.width, density_level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            glFinish();
+            
+            density_level.image_GL = cl::ImageGL(context, CL_MEM_READ_WRITE, GL_TEXTURE_2D, 0, density_level.texture_ID);
+            density_levels.push_back(density_level);
+        }
+    }
+    
+    void deleteDensityLevels() {
+        std::vector<GLuint> textures;
+        for(const DensityLevel& density_level : density_levels) textures.push_back(density_level.texture_ID);
+        
+        density_levels.clear(); // the OpenCL images go before their textures
+        if(!textures.empty()) glDeleteTextures((GLsizei)textures.size(), textures.data());
+        density_key.clear();
+    }
+    
+    // the image the renderer samples and its generation
+    ImageGLObj& imageShown() {
+        return decoupled ? display_images[display_drawn] : images[current];
+    }
+    
+    unsigned long long generationShown() const {
+        return decoupled ? display_generations[display_drawn] : generation;
+    }
+    
+    // the three display images all start with the current generation
+    void createDisplayImages() {
+        for(int i = 0; i < 3; i++) {
+            display_images[i] = ImageGLObj(width, height, context);
+            display_generations[i] = generation;
+            copyImage(images[current], display_images[i]);
+        }
+        display_back = 0;
+        display_front = 1;
+        display_drawn = 2;
+        display_fresh = false;
+    }
     
-    KernelGL(const char* kernel_path, const char* kernel_name) {
+    // copy the state of one image into another on the queue of the iterations, blocking
+    void copyImage(ImageGLObj& image_from, ImageGLObj& image_to) {
+        std::vector<cl::Memory> copy_objs = {image_from.image_GL, image_to.image_GL};
+        queue.enqueueAcquireGLObjects(&copy_objs);
+        queue.enqueueCopyImage(image_from.image_GL, image_to.image_GL, {0, 0, 0}, {0, 0, 0}, {(size_t)width, (size_t)height, 1});
+        queue.enqueueReleaseGLObjects(&copy_objs);
+        queue.finish();
+    }
+    
+    // reduce the levels 1..level over the part of the board in view: the top level over the texels in view and a texel around them,
+    // every level below it over twice that and a texel more on each side, for the odd sizes
+    void buildDensity(int level, float u_min, float v_min, float u_size, float v_size) {
+        createDensityLevels(level);
+        
+        std::vector<int> regions(4 * (level + 1));
+        int x0 = (int)std::floor(u_min * density_levels[level - 1].width) - 1;
+        int y0 = (int)std::floor(v_min * density_levels[level - 1].height) - 1;
+        int span_x = (int)std::ceil(u_size * density_levels[level - 1].width) + 3;
+        int span_y = (int)std::ceil(v_size * density_levels[level - 1].height) + 3;
+        
+        for(int l = level; l >= 1; l--) {
+            const DensityLevel& density_level = density_levels[l - 1];
+            int* region = &regions[4 * l];
+            region[0] = (x0 % density_level.width + density_level.width) % density_level.width;
+            region[1] = (y0 % density_level.height + density_level.height) % density_level.height;
+            region[2] = std::min(span_x, density_level.width);
+            region[3] = std::min(span_y, density_level.height);
+            
+            x0 = 2 * x0 - 1;
+            y0 = 2 * y0 - 1;
+            span_x = 2 * span_x + 2;
+            span_y = 2 * span_y + 2;
+        }
+        
+        // nothing to do when neither the board nor the view has changed since the last build
+        std::vector<long long> key = {(long long)generationShown(), level};
+        key.insert(key.end(), regions.begin() + 4 * level, regions.end());
+        if(key == density_key) return;
+        density_key = key;
+        
+        std::vector<cl::Memory> density_objs = {imageShown().image_GL};
+        for(int l = 0; l < level; l++) density_objs.push_back(density_levels[l].image_GL);
+        
+        cl::Event acquire_event, release_event;
+        render_queue.enqueueAcquireGLObjects(&density_objs, NULL, &acquire_event);
+        for(int l = 1; l <= level; l++) {
+            cl::Kernel& reduce_kernel = l == 1 ? reduce_cells_kernel : reduce_density_kernel;
+            reduce_kernel.setArg(0, l == 1 ? imageShown().image_GL : density_levels[l - 2].image_GL);
+            reduce_kernel.setArg(1, density_levels[l - 1].image_GL);
+            reduce_kernel.setArg(2, regions[4 * l]);
+            reduce_kernel.setArg(3, regions[4 * l + 1]);
+            render_queue.enqueueNDRangeKernel(reduce_kernel, cl::NullRange, cl::NDRange(size_t(regions[4 * l + 2]), size_t(regions[4 * l + 3])), cl::NullRange);
+        }
+        render_queue.enqueueReleaseGLObjects(&density_objs, NULL, &release_event);
+        release_event.wait();
+        
+        if(metrics) metrics->record("cl_density", eventSeconds(acquire_event.getProfilingInfo<CL_PROFILING_COMMAND_END>(), release_event.getProfilingInfo<CL_PROFILING_COMMAND_START>()));
+    }
+        
+    void createImages(const ImageGLObj& image_initial) {
+        images[0] = image_initial;
+        images[1] = ImageGLObj(image_initial.width, image_initial.height, context);
+        current = 0;
+        
+        width = image_initial.width;
+        height = image_initial.height;
+        generation = 0;
+        createTiles();
+        setKernelArgs();
+        deleteDensityLevels();
+        if(decoupled) createDisplayImages();
+    }
+
+public:
+    KernelGL(const char* kernel_path, const char* kernel_name) : iteration_pending(false), metrics(nullptr), current(0), active_tracking(true), tiles_stale(false), generations_per_launch(1), ltl_enabled(false), ltl_sums_width(0), ltl_sums_height(0), lenia_enabled(false), decoupled(false) {
+        kernel_name_iterate = kernel_name;
+        kernel_source = loadSource(kernel_path);
+        
         try {
-            buildProgram(kernel_path);
-            createKernel(kernel_name);
+            createContext();
+            buildProgram();
+            createKernel();
+            createTransitions();
         } catch(cl::Error e) {
             processError(e);
         }
@@ -255,41 +781,245 @@ public:
         // create two images and swap them with each iteration
         
         try {
-            image_out = ImageGLObj(texture_path, kernel_name, device, context, program);
+            waitForIteration();
+            createImages(ImageGLObj(texture_path, kernel_name, queue, context, program));
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    // step only the tiles around the ones that changed, on by default
+    void setActiveTracking(bool active_tracking_u) {
+        active_tracking = active_tracking_u;
+        
+        // the change flags go stale while the tracking is off
+        if(active_tracking && width > 0) {
+            try {
+                waitForIteration();
+                createTiles();
+                setKernelArgs();
+            } catch(cl::Error e) {
+                processError(e);
+            }
+        }
+    }
+    
+    // generations advanced by each launch, above 1 the kernel iterates in local memory and the active-region tracking is paused
+    void setGenerationsPerLaunch(unsigned int generations_per_launch_u) {
+        if(generations_per_launch_u == 0) generations_per_launch_u = 1;
+        
+        size_t side = CL_TILE_SIZE + 2 * generations_per_launch_u;
+        if(2 * side * side > device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>()) {
+            std::cerr << "ERROR: OpenCL: NOT ENOUGH LOCAL MEMORY FOR " << generations_per_launch_u << " GENERATIONS PER LAUNCH" << std::endl;
+            exit(-1);
+        }
+        
+        generations_per_launch = generations_per_launch_u;
+    }
+    
+    // switch to a Larger-than-Life rule, setRule() switches back to the Life-like ones
+    void setRuleLtL(const RuleLtL& rule_ltl_u) {
+        ltl_enabled = true;
+        lenia_enabled = false;
+        rule_ltl = rule_ltl_u;
+        
+        try {
+            waitForIteration();
+            if(width > 0) createLtL();
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    // switch to a Lenia rule, setRule() switches back to the Life-like ones
+    void setRuleLenia(const RuleLenia& rule_lenia_u) {
+        lenia_enabled = true;
+        ltl_enabled = false;
+        rule_lenia = rule_lenia_u;
+        
+        try {
+            waitForIteration();
+            if(width > 0) createLenia();
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    // record the timings of the stages to metrics from now on, nullptr to stop
+    void setMetrics(Metrics* metrics_u) {
+        metrics = metrics_u;
+        profiled_iterations.clear();
+    }
+    
+    // block until the last submitted iteration is done, OpenGL can then use the texture again
+    void waitForIteration() {
+        if(!iteration_pending) return;
         
-            width = image_out.width;
-            height = image_out.height;
-            cl::ImageFormat image_format(CL_RGBA, CL_SIGNED_INT8);
-            image_in = cl::Image2D(context, CL_MEM_READ_ONLY, image_format, width, height);
+        try {
+            auto wait_start = std::chrono::steady_clock::now();
+            iteration_event.wait();
+            
+            if(metrics) {
+                metrics->record("host_wait", std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start).count());
+                recordIterations();
+            }
         } catch(cl::Error e) {
             processError(e);
         }
+        iteration_pending = false;
+    }
+    
+    // draw the display images published by a simulation thread rather than the state images, the board has to be loaded again to take effect
+    // only publish() and the calls the thread makes to step the board may then come from the simulation thread, the rest from the thread of OpenGL
+    void setDecoupled(bool decoupled_u) {
+        decoupled = decoupled_u;
+        
+        if(decoupled && width > 0) {
+            try {
+                waitForIteration();
+                createDisplayImages();
+            } catch(cl::Error e) {
+                processError(e);
+            }
+        }
+    }
+    
+    // copy the newest generation to the display image written next and make it the newest one published, on the simulation thread
+    void publish() {
+        try {
+            waitForIteration();
+            copyImage(images[current], display_images[display_back]);
+        } catch(cl::Error e) {
+            processError(e);
+        }
+        
+        std::lock_guard<std::mutex> lock(display_mutex);
+        display_generations[display_back] = generation;
+        std::swap(display_back, display_front);
+        display_fresh = true;
     }
     
     void transferData(Shader& shader, const char* shader_tex_id) {
-        image_out.transferImageToShader(shader, shader_tex_id);
+        // the renderer only samples finished generations: the newest one published, or the state once the pending iteration is done
+        // the display image drawn before is handed back to the simulation thread here, after the draw calls of the frame before were flushed
+        
+        if(decoupled) {
+            std::lock_guard<std::mutex> lock(display_mutex);
+            if(display_fresh) {
+                std::swap(display_drawn, display_front);
+                display_fresh = false;
+            }
+        } else {
+            waitForIteration();
+        }
+        imageShown().transferImageToShader(shader, shader_tex_id);
+        
+        // the shader colours the dying cells of the Generations rules by their state
+        shader.setInt("states", (ltl_enabled || lenia_enabled) ? 2 : (int)rule.states);
+    }
+    
+    // pass the level of the density pyramid matching the zoom of the camera to the shader, built first over the part of the board in view
+    // at level 0 the shader samples the cells themselves
+    void transferDensity(Shader& shader, const char* shader_tex_id, const Camera& camera) {
+        int level = camera.level(width, height);
+        while(level > 0 && ((std::max(width, height) - 1) >> (level - 1)) == 0) level--; // no level past the one of a single texel
+        
+        // the sampler keeps a unit of its own even when unused, OpenGL does not draw with two types of samplers on one unit
+        shader.use();
+        shader.setInt("level", level);
+        glUniform1i(glGetUniformLocation(shader.ID, shader_tex_id), 1);
+        if(level == 0) return;
+        
+        float u_min, v_min, u_size, v_size;
+        camera.visibleRegion(u_min, v_min, u_size, v_size);
+        
+        try {
+            if(!decoupled) waitForIteration();
+            buildDensity(level, u_min, v_min, u_size, v_size);
+        } catch(cl::Error e) {
+            processError(e);
+        }
+        
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, density_levels[level - 1].texture_ID);
+        glActiveTexture(GL_TEXTURE0);
     }
     
     void iterate() {
         try {
-            // create a command queue and enqueue the kernel to process the current input image
-            
-            std::vector<cl::Memory> mem_objs;
-            
-            mem_objs.push_back(image_out.image_GL);
-            
-            // set the kernel arguments
+            enqueueIteration(launchGenerations());
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    const char* name() const {
+        return "opencl";
+    }
+    
+    // one RGBA texel read and one written
+    double bytesPerCell() const {
+        return 8.0;
+    }
+    
+    void setRule(const Rule& rule_u) {
+        if(rule == rule_u && !ltl_enabled && !lenia_enabled) return;
+        rule = rule_u;
+        ltl_enabled = false;
+        lenia_enabled = false;
+        
+        try {
+            waitForIteration();
+            buildProgram();
+            createKernel();
+            createTransitions();
             
-            setKernelArgs();
+            if(width > 0) {
+                setKernelArgs();
+                tiles_stale = true; // the change flags were computed under the old rule
+            }
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    void load(const unsigned char* cells, int width_u, int height_u) {
+        try {
+            waitForIteration();
+            createImages(ImageGLObj(cells, width_u, height_u, context));
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    void step(unsigned int generations = 1) {
+        try {
+            while(generations > 0) {
+                unsigned int k = std::min(generations, launchGenerations());
+                enqueueIteration(k);
+                generations -= k;
+            }
+        } catch(cl::Error e) {
+            processError(e);
+        }
+        waitForIteration();
+    }
+    
+    void read(unsigned char* cells) {
+        try {
+            std::vector<unsigned char> texture_data(4 * (size_t)width * height);
             
-            // make sure the OpenGL has freed the texture before proceeding
+            // the read is queued behind the pending iterations
             
-            cl::CommandQueue queue(context, device);
+            cl::Event read_event;
             queue.enqueueAcquireGLObjects(&mem_objs);
-            queue.enqueueCopyImage(image_out.image_GL, image_in, {0, 0, 0}, {0, 0, 0}, {(size_t)width, (size_t)height, 1});
-            queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(size_t(width), size_t(height)), cl::NullRange);
+            queue.enqueueReadImage(images[current].image_GL, CL_TRUE, {0, 0, 0}, {(size_t)width, (size_t)height, 1}, 0, 0, texture_data.data(), NULL, &read_event);
             queue.enqueueReleaseGLObjects(&mem_objs);
             queue.finish();
+            
+            if(metrics) metrics->record("cl_read", eventSeconds(read_event.getProfilingInfo<CL_PROFILING_COMMAND_START>(), read_event.getProfilingInfo<CL_PROFILING_COMMAND_END>()));
+            
+            for(size_t i = 0; i < (size_t)width * height; i++) cells[i] = texture_data[4 * i];
         } catch(cl::Error e) {
             processError(e);
         }
@@ -0,0 +1,172 @@
+//
+//  kernel_ensemble.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef kernel_ensemble_h
+#define kernel_ensemble_h
+
+// include the standard libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+// include the OpenCL library (C++ binding)
+#define __CL_ENABLE_EXCEPTIONS
+#define CL_HPP_TARGET_OPENCL_VERSION 120
+#define CL_HPP_MINIMUM_OPENCL_VERSION 120
+#include "cl2.hpp"
+#include "opencl_error.h"
+
+#include "ensemble.h"
+#include "program_cache.h"
+
+// the ensemble on the OpenCL device: all the boards in one buffer and one launch per generation, (width, height, boards) work-items
+// the program, the context and the queue are created once for the whole ensemble, without an OpenGL context
+class EnsembleCL : public Ensemble {
+private:
+    cl::Device device;
+    cl::Context context;
+    cl::CommandQueue queue;
+    cl::Program program;
+    
+    // ping-pong buffers, cells[current] holds the newest generation and kernels[current] steps it into the other one
+    cl::Kernel kernels[2];
+    cl::Buffer cells[2], rules_buffer;
+    int current;
+    
+    void processError(cl::Error& e) {
+        std::cerr << "ERROR: OpenCL: ENSEMBLE: " << e.what() << ": " << e.err() << std::endl;
+        if(e.err() == CL_BUILD_PROGRAM_FAILURE) {
+            std::cerr << "ERROR: OpenCL: CANNOT BUILD PROGRAM: " << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
+        } else {
+            std::cerr << oclErrorString(e.err()) << std::endl;
+        }
+        
+        exit(-1);
+    }
+    
+    void createContext() {
+        std::vector<cl::Platform> platforms;
+        std::vector<cl::Device> devices;
+        
+        cl::Platform::get(&platforms);
+        if(platforms.size() == 0) {
+            std::cerr << "ERROR: OpenCL: NO PLATFORMS FOUND" << std::endl;
+            exit(-1);
+        }
+        
+        platforms[0].getDevices(CL_DEVICE_TYPE_GPU, &devices);
+        if(devices.size() == 0) {
+            std::cerr << "ERROR: OpenCL: NO DEVICES FOUND" << std::endl;
+            exit(-1);
+        }
+        
+        device = devices[devices.size() > 1 ? 1 : 0]; // the graphics card, as in KernelGL
+        std::cout << "SUCCESS: OpenCL: ENSEMBLE: USING A DEVICE: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
+        
+        context = cl::Context(device);
+        queue = cl::CommandQueue(context, device);
+    }
+    
+    void buildProgram(const char* kernel_path) {
+        std::string kernel_code;
+        std::ifstream kernel_file;
+        kernel_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        
+        try {
+            kernel_file.open(kernel_path);
+            std::ostringstream kernel_stream;
+            kernel_stream << kernel_file.rdbuf();
+            kernel_file.close();
+            kernel_code = kernel_stream.str();
+        } catch(std::ifstream::failure e) {
+            std::cerr << "ERROR: OpenCL KERNEL: CANNOT READ KERNEL CODE" << std::endl;
+            exit(-1);
+        }
+        
+        // the rules are read from a buffer, one program serves every board
+        
+        ProgramCache().build(program, context, device, kernel_code, "");
+        
+        for(int i = 0; i < 2; i++) kernels[i] = cl::Kernel(program, "iterateEnsemble");
+    }
+
+public:
+    EnsembleCL(const char* kernel_path) : current(0) {
+        try {
+            createContext();
+            buildProgram(kernel_path);
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    const char* name() const {
+        return "opencl";
+    }
+    
+    void load(const unsigned char* cells_in, const Rule* rules, int width_u, int height_u, int boards_num_u) {
+        width = width_u;
+        height = height_u;
+        boards_num = boards_num_u;
+        generation = 0;
+        current = 0;
+        
+        size_t cells_num = (size_t)width * height * boards_num;
+        
+        std::vector<cl_uint> rules_data(2 * (size_t)boards_num);
+        for(int b = 0; b < boards_num; b++) {
+            requireTwoStates(rules[b], name());
+            rules_data[2 * b] = rules[b].birth;
+            rules_data[2 * b + 1] = rules[b].survival;
+        }
+        
+        try {
+            std::vector<unsigned char> cells_data(cells_num);
+            for(size_t i = 0; i < cells_num; i++) cells_data[i] = cells_in[i] > 0 ? COLOR_MAX : 0;
+            
+            cells[0] = cl::Buffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, cells_num, cells_data.data());
+            cells[1] = cl::Buffer(context, CL_MEM_READ_WRITE, cells_num);
+            rules_buffer = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, rules_data.size() * sizeof(cl_uint), rules_data.data());
+            
+            for(int i = 0; i < 2; i++) {
+                kernels[i].setArg(0, cells[i]);
+                kernels[i].setArg(1, cells[1 - i]);
+                kernels[i].setArg(2, rules_buffer);
+                kernels[i].setArg(3, width);
+                kernels[i].setArg(4, height);
+            }
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    void step(unsigned int generations = 1) {
+        try {
+            for(unsigned int i = 0; i < generations; i++) {
+                queue.enqueueNDRangeKernel(kernels[current], cl::NullRange, cl::NDRange(size_t(width), size_t(height), size_t(boards_num)), cl::NullRange);
+                current = 1 - current;
+            }
+            queue.finish();
+        } catch(cl::Error e) {
+            processError(e);
+        }
+        
+        generation += generations;
+    }
+    
+    void read(unsigned char* cells_out) {
+        try {
+            queue.enqueueReadBuffer(cells[current], CL_TRUE, 0, (size_t)width * height * boards_num, cells_out);
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+};
+
+#endif /* kernel_ensemble_h */
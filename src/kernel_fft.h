@@ -0,0 +1,148 @@
+//
+//  kernel_fft.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef kernel_fft_h
+#define kernel_fft_h
+
+// include the standard libraries
+#include <vector>
+#include <algorithm>
+
+// include the OpenCL library (C++ binding)
+#define __CL_ENABLE_EXCEPTIONS
+#define CL_HPP_TARGET_OPENCL_VERSION 120
+#define CL_HPP_MINIMUM_OPENCL_VERSION 120
+#include "cl2.hpp"
+
+#include "fft.h"
+
+// 2D FFT of a width x height buffer of float2 on the OpenCL device, the rows and then the columns
+// the power-of-two lines go through the Stockham passes, which alternate between the two data buffers, the other lines through Bluestein's algorithm
+// in batches of lines that fit a work buffer of the size of the board
+class FFTCL {
+private:
+    struct Dimension {
+        int n, lines, stride, dist;
+        int m, batch; // Bluestein's algorithm: the length of the power-of-two transforms and the lines transformed at once
+        cl::Buffer chirp, chirp_spectrum;
+    };
+    
+    cl::Kernel pass_kernel, chirp_in_kernel, chirp_multiply_kernel, chirp_out_kernel;
+    Dimension dimensions[2]; // the rows and the columns
+    cl::Buffer work[2];
+    
+    void enqueuePasses(cl::CommandQueue& queue, cl::Buffer buffers[2], int& current, int n, int lines, int stride, int dist, float direction) {
+        for(int p = 1; p < n; p <<= 1) {
+            pass_kernel.setArg(0, buffers[current]);
+            pass_kernel.setArg(1, buffers[1 - current]);
+            pass_kernel.setArg(2, n);
+            pass_kernel.setArg(3, stride);
+            pass_kernel.setArg(4, dist);
+            pass_kernel.setArg(5, p);
+            pass_kernel.setArg(6, direction);
+            
+            queue.enqueueNDRangeKernel(pass_kernel, cl::NullRange, cl::NDRange(size_t(n / 2), size_t(lines)), cl::NullRange);
+            current = 1 - current;
+        }
+    }
+    
+    void enqueueDimension(cl::CommandQueue& queue, Dimension& dimension, cl::Buffer data[2], int& current, float direction) {
+        if(fftPowerOfTwo(dimension.n)) {
+            enqueuePasses(queue, data, current, dimension.n, dimension.lines, dimension.stride, dimension.dist, direction);
+            return;
+        }
+        
+        // the batches read their lines from data[current] and write them back in place
+        
+        for(int line_begin = 0; line_begin < dimension.lines; line_begin += dimension.batch) {
+            int batch = std::min(dimension.batch, dimension.lines - line_begin);
+            int work_current = 0;
+            
+            chirp_in_kernel.setArg(0, data[current]);
+            chirp_in_kernel.setArg(1, work[0]);
+            chirp_in_kernel.setArg(2, dimension.n);
+            chirp_in_kernel.setArg(3, dimension.stride);
+            chirp_in_kernel.setArg(4, dimension.dist);
+            chirp_in_kernel.setArg(5, dimension.m);
+            chirp_in_kernel.setArg(6, line_begin);
+            chirp_in_kernel.setArg(7, dimension.chirp);
+            chirp_in_kernel.setArg(8, direction);
+            queue.enqueueNDRangeKernel(chirp_in_kernel, cl::NullRange, cl::NDRange(size_t(dimension.m), size_t(batch)), cl::NullRange);
+            
+            enqueuePasses(queue, work, work_current, dimension.m, batch, 1, dimension.m, -1.0f);
+            
+            chirp_multiply_kernel.setArg(0, work[work_current]);
+            chirp_multiply_kernel.setArg(1, dimension.chirp_spectrum);
+            chirp_multiply_kernel.setArg(2, dimension.m);
+            chirp_multiply_kernel.setArg(3, direction);
+            queue.enqueueNDRangeKernel(chirp_multiply_kernel, cl::NullRange, cl::NDRange(size_t(dimension.m), size_t(batch)), cl::NullRange);
+            
+            enqueuePasses(queue, work, work_current, dimension.m, batch, 1, dimension.m, 1.0f);
+            
+            chirp_out_kernel.setArg(0, work[work_current]);
+            chirp_out_kernel.setArg(1, data[current]);
+            chirp_out_kernel.setArg(2, dimension.n);
+            chirp_out_kernel.setArg(3, dimension.stride);
+            chirp_out_kernel.setArg(4, dimension.dist);
+            chirp_out_kernel.setArg(5, dimension.m);
+            chirp_out_kernel.setArg(6, line_begin);
+            chirp_out_kernel.setArg(7, dimension.chirp);
+            chirp_out_kernel.setArg(8, direction);
+            queue.enqueueNDRangeKernel(chirp_out_kernel, cl::NullRange, cl::NDRange(size_t(dimension.n), size_t(batch)), cl::NullRange);
+        }
+    }
+
+public:
+    void createKernels(cl::Program& program) {
+        pass_kernel = cl::Kernel(program, "fftPass");
+        chirp_in_kernel = cl::Kernel(program, "fftChirpIn");
+        chirp_multiply_kernel = cl::Kernel(program, "fftChirpMultiply");
+        chirp_out_kernel = cl::Kernel(program, "fftChirpOut");
+    }
+    
+    void create(cl::Context& context, int width, int height) {
+        size_t cells_num = (size_t)width * height;
+        size_t work_size = 0;
+        
+        dimensions[0].n = width;
+        dimensions[0].lines = height;
+        dimensions[0].stride = 1;
+        dimensions[0].dist = width;
+        
+        dimensions[1].n = height;
+        dimensions[1].lines = width;
+        dimensions[1].stride = width;
+        dimensions[1].dist = 1;
+        
+        for(Dimension& dimension : dimensions) {
+            if(fftPowerOfTwo(dimension.n)) continue;
+            
+            // the chirps come from the host transform of the same length
+            FFT fft(dimension.n);
+            std::vector<Complex> chirp = fft.chirpValues(), chirp_spectrum = fft.chirpSpectrum();
+            
+            dimension.m = fft.scratchSize();
+            dimension.batch = (int)std::max((size_t)1, std::min((size_t)dimension.lines, cells_num / dimension.m));
+            dimension.chirp = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, chirp.size() * sizeof(cl_float2), chirp.data());
+            dimension.chirp_spectrum = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, chirp_spectrum.size() * sizeof(cl_float2), chirp_spectrum.data());
+            
+            work_size = std::max(work_size, (size_t)dimension.batch * dimension.m);
+        }
+        
+        if(work_size > 0) for(int i = 0; i < 2; i++) work[i] = cl::Buffer(context, CL_MEM_READ_WRITE, work_size * sizeof(cl_float2));
+    }
+    
+    // transform data[current], the power-of-two passes move the result between the buffers and update current, the inverse transform is not divided by width * height
+    void enqueue(cl::CommandQueue& queue, cl::Buffer data[2], int& current, bool inverse) {
+        float direction = inverse ? 1.0f : -1.0f;
+        
+        for(Dimension& dimension : dimensions) enqueueDimension(queue, dimension, data, current, direction);
+    }
+};
+
+#endif /* kernel_fft_h */
@@ -0,0 +1,404 @@
+//
+//  kernel_multi.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef kernel_multi_h
+#define kernel_multi_h
+
+// include the standard libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+// include the OpenCL library (C++ binding)
+#define __CL_ENABLE_EXCEPTIONS
+#define CL_HPP_TARGET_OPENCL_VERSION 120
+#define CL_HPP_MINIMUM_OPENCL_VERSION 120
+#include "cl2.hpp"
+#include "opencl_error.h"
+
+#include "engine.h"
+#include "program_cache.h"
+
+#define MULTI_BALANCE_GENERATIONS 64 // the strips are resized at most once per this many generations
+#define MULTI_BALANCE_THRESHOLD 0.05 // and only when a strip is off its share by more than this fraction of the board
+
+// the board split into horizontal strips, one per OpenCL device of every platform, each device with its own context and queues
+// a strip keeps halo rows of its neighbours above and below: with a halo of k rows the strips step k generations on their own,
+// the rows they can step shrinking by one at each side every generation, and then exchange the k boundary rows through the host
+// the boundary rows are stepped first, so that their copies on the second queue of the device overlap with the interior
+// the rows of the strips follow the throughput of the devices measured by the profiling events of their kernels
+class KernelMulti : public Engine {
+private:
+    struct Strip {
+        cl::Device device;
+        cl::Context context;
+        cl::CommandQueue queue, copy_queue; // the kernels and the copies of the halo rows
+        cl::Program program;
+        cl::Kernel kernels[2];
+        cl::Buffer cells[2]; // rows + 2 * halo rows, cells[current] holds the newest generation
+        int row_begin, rows; // the rows of the board stepped by the strip
+        
+        // the boundary rows sent to the neighbours (top and bottom), on the host for two exchanges in turn
+        // a neighbour may still be writing the rows of the last exchange into its halo while the next ones are read
+        std::vector<unsigned char> edges[2][2];
+        cl::Event read_events[2];
+        std::vector<cl::Event> write_events; // the halo writes the next generation waits for
+        
+        // the first and the last kernel of every cycle since the last balance, and the cells they stepped
+        std::vector<std::pair<cl::Event, cl::Event>> timed_cycles;
+        double cells_stepped;
+    };
+    
+    std::string kernel_source;
+    std::vector<Strip> strips;
+    int strip_building;
+    int halo;
+    int current;
+    int parity; // of the staging rows of the exchanges
+    unsigned int generations_balanced; // since the last balance
+    
+    void processError(cl::Error& e) {
+        std::cerr << "ERROR: OpenCL: MULTI: " << e.what() << ": " << e.err() << std::endl;
+        if(e.err() == CL_BUILD_PROGRAM_FAILURE) {
+            Strip& strip = strips[strip_building];
+            std::cerr << "ERROR: OpenCL: CANNOT BUILD PROGRAM: " << strip.program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(strip.device) << std::endl;
+        } else {
+            std::cerr << oclErrorString(e.err()) << std::endl;
+        }
+        
+        exit(-1);
+    }
+    
+    void loadSource(const char* kernel_path) {
+        std::ifstream kernel_file;
+        kernel_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        
+        try {
+            kernel_file.open(kernel_path);
+            std::ostringstream kernel_stream;
+            kernel_stream << kernel_file.rdbuf();
+            kernel_file.close();
+            kernel_source = kernel_stream.str();
+        } catch(std::ifstream::failure e) {
+            std::cerr << "ERROR: OpenCL KERNEL: CANNOT READ KERNEL CODE" << std::endl;
+            exit(-1);
+        }
+    }
+    
+    void createContexts() {
+        std::vector<cl::Platform> platforms;
+        
+        cl::Platform::get(&platforms);
+        for(cl::Platform& platform : platforms) {
+            std::vector<cl::Device> devices;
+            try {
+                platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
+            } catch(cl::Error e) {
+                continue; // a platform without devices
+            }
+            
+            for(cl::Device& device : devices) {
+                Strip strip;
+                strip.device = device;
+                strip.context = cl::Context(device);
+                strip.queue = cl::CommandQueue(strip.context, device, CL_QUEUE_PROFILING_ENABLE);
+                strip.copy_queue = cl::CommandQueue(strip.context, device);
+                strip.row_begin = strip.rows = 0;
+                strip.cells_stepped = 0.0;
+                strips.push_back(strip);
+                
+                std::cout << "SUCCESS: OpenCL: MULTI: USING A DEVICE: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
+            }
+        }
+        
+        if(strips.empty()) {
+            std::cerr << "ERROR: OpenCL: NO DEVICES FOUND" << std::endl;
+            exit(-1);
+        }
+    }
+    
+    void buildPrograms() {
+        // the rule masks become constants of the kernels, as in KernelGL
+        std::string options = "-D RULE_BIRTH=" + std::to_string(rule.birth) + "u";
+        options += " -D RULE_SURVIVAL=" + std::to_string(rule.survival) + "u";
+        
+        ProgramCache program_cache;
+        for(strip_building = 0; strip_building < (int)strips.size(); strip_building++) {
+            Strip& strip = strips[strip_building];
+            program_cache.build(strip.program, strip.context, strip.device, kernel_source, options);
+            for(int i = 0; i < 2; i++) strip.kernels[i] = cl::Kernel(strip.program, "iterateStrip");
+        }
+    }
+    
+    void setKernelArgs() {
+        for(Strip& strip : strips) for(int i = 0; i < 2; i++) {
+            strip.kernels[i].setArg(0, strip.cells[i]);
+            strip.kernels[i].setArg(1, strip.cells[1 - i]);
+            strip.kernels[i].setArg(2, width);
+        }
+    }
+    
+    // the rows of the board in proportion to the weights of the strips, at least halo rows each
+    std::vector<int> splitRows(const std::vector<double>& weights) const {
+        int strips_num = (int)strips.size();
+        if(height < strips_num * halo) {
+            std::cerr << "ERROR: OpenCL: MULTI: THE BOARD HAS FEWER THAN " << halo << " ROWS PER DEVICE" << std::endl;
+            exit(-1);
+        }
+        
+        double weights_sum = 0.0;
+        for(double weight : weights) weights_sum += weight;
+        
+        int rows_free = height - strips_num * halo;
+        int rows_sum = 0;
+        std::vector<int> rows(strips_num);
+        for(int i = 0; i < strips_num; i++) {
+            rows[i] = halo + (int)(rows_free * weights[i] / weights_sum);
+            rows_sum += rows[i];
+        }
+        rows.back() += height - rows_sum; // the rounding
+        
+        return rows;
+    }
+    
+    void setRows(const std::vector<int>& rows) {
+        int row_begin = 0;
+        for(size_t i = 0; i < strips.size(); i++) {
+            strips[i].row_begin = row_begin;
+            strips[i].rows = rows[i];
+            row_begin += rows[i];
+        }
+    }
+    
+    void createBuffers(const unsigned char* cells_in) {
+        for(Strip& strip : strips) {
+            size_t strip_size = (size_t)(strip.rows + 2 * halo) * width;
+            
+            // the interior rows and the halo rows, wrapped around the board
+            std::vector<unsigned char> cells_data(strip_size);
+            for(int r = 0; r < strip.rows + 2 * halo; r++) {
+                const unsigned char* row = cells_in + (size_t)((strip.row_begin - halo + r + height) % height) * width;
+                for(int x = 0; x < width; x++) cells_data[(size_t)r * width + x] = row[x] > 0 ? COLOR_MAX : 0;
+            }
+            
+            strip.cells[0] = cl::Buffer(strip.context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, strip_size, cells_data.data());
+            strip.cells[1] = cl::Buffer(strip.context, CL_MEM_READ_WRITE, strip_size);
+            
+            for(int p = 0; p < 2; p++) for(int e = 0; e < 2; e++) strip.edges[p][e].resize((size_t)halo * width);
+            strip.write_events.clear();
+            strip.timed_cycles.clear();
+            strip.cells_stepped = 0.0;
+        }
+        
+        current = 0;
+        generations_balanced = 0;
+        setKernelArgs();
+    }
+    
+    void enqueueRows(Strip& strip, int c, int row_begin, int row_end, const std::vector<cl::Event>* events, cl::Event* event) {
+        strip.queue.enqueueNDRangeKernel(strip.kernels[c], cl::NDRange(0, size_t(row_begin)), cl::NDRange(size_t(width), size_t(row_end - row_begin)), cl::NullRange, events, event);
+    }
+    
+    // g <= halo generations on every strip and the exchange of the boundary rows
+    void enqueueCycle(int g) {
+        int k = halo;
+        int c_end = (current + g) % 2; // the buffers holding the generation after the cycle
+        
+        for(Strip& strip : strips) {
+            int h = strip.rows;
+            int c = current;
+            cl::Event begin_event, edges_event, end_event;
+            const std::vector<cl::Event>* wait_events = strip.write_events.empty() ? nullptr : &strip.write_events;
+            
+            // the buffer rows [i, h + 2k - i) are valid after i generations of the cycle
+            for(int i = 1; i < g; i++) {
+                enqueueRows(strip, c, i, h + 2 * k - i, i == 1 ? wait_events : nullptr, i == 1 ? &begin_event : nullptr);
+                c = 1 - c;
+            }
+            
+            // the last generation steps only the rows of the strip, the halo rows come from the exchange
+            // the boundary rows first, then the interior while they are copied
+            
+            bool first = g == 1;
+            if(h > 2 * k) {
+                enqueueRows(strip, c, k, 2 * k, first ? wait_events : nullptr, first ? &begin_event : nullptr);
+                enqueueRows(strip, c, h, h + k, nullptr, &edges_event);
+                enqueueRows(strip, c, 2 * k, h, nullptr, &end_event);
+            } else {
+                enqueueRows(strip, c, k, h + k, first ? wait_events : nullptr, &edges_event);
+                end_event = edges_event;
+                if(first) begin_event = edges_event;
+            }
+            
+            std::vector<cl::Event> edges_events(1, edges_event);
+            size_t edge_size = (size_t)k * width;
+            strip.copy_queue.enqueueReadBuffer(strip.cells[c_end], CL_FALSE, (size_t)k * width, edge_size, strip.edges[parity][0].data(), &edges_events, &strip.read_events[0]);
+            strip.copy_queue.enqueueReadBuffer(strip.cells[c_end], CL_FALSE, (size_t)h * width, edge_size, strip.edges[parity][1].data(), &edges_events, &strip.read_events[1]);
+            
+            strip.queue.flush();
+            strip.copy_queue.flush();
+            
+            strip.timed_cycles.push_back(std::make_pair(begin_event, end_event));
+            strip.cells_stepped += (double)g * h * width;
+        }
+        
+        // the bottom rows of the strip above become the top halo, the top rows of the strip below the bottom halo
+        
+        for(Strip& strip : strips) for(cl::Event& read_event : strip.read_events) read_event.wait();
+        
+        int strips_num = (int)strips.size();
+        for(int i = 0; i < strips_num; i++) {
+            Strip& strip = strips[i];
+            Strip& strip_above = strips[(i + strips_num - 1) % strips_num];
+            Strip& strip_below = strips[(i + 1) % strips_num];
+            size_t edge_size = (size_t)k * width;
+            
+            strip.write_events.resize(2);
+            strip.copy_queue.enqueueWriteBuffer(strip.cells[c_end], CL_FALSE, 0, edge_size, strip_above.edges[parity][1].data(), nullptr, &strip.write_events[0]);
+            strip.copy_queue.enqueueWriteBuffer(strip.cells[c_end], CL_FALSE, (size_t)(strip.rows + k) * width, edge_size, strip_below.edges[parity][0].data(), nullptr, &strip.write_events[1]);
+            strip.copy_queue.flush();
+        }
+        
+        current = c_end;
+        parity = 1 - parity;
+        generation += g;
+    }
+    
+    void finish() {
+        for(Strip& strip : strips) {
+            strip.queue.finish();
+            strip.copy_queue.finish();
+        }
+    }
+    
+    void readStrips(unsigned char* cells_out) {
+        finish();
+        for(Strip& strip : strips) {
+            strip.queue.enqueueReadBuffer(strip.cells[current], CL_TRUE, (size_t)halo * width, (size_t)strip.rows * width, cells_out + (size_t)strip.row_begin * width);
+        }
+    }
+    
+    // resize the strips in proportion to the cells per second of their devices over the last cycles
+    void balance() {
+        generations_balanced = 0;
+        if(strips.size() < 2) {
+            strips[0].timed_cycles.clear();
+            return;
+        }
+        
+        finish();
+        
+        std::vector<double> throughputs;
+        for(Strip& strip : strips) {
+            double busy_time = 0.0;
+            for(const auto& events : strip.timed_cycles) {
+                busy_time += (events.second.getProfilingInfo<CL_PROFILING_COMMAND_END>() - events.first.getProfilingInfo<CL_PROFILING_COMMAND_START>()) * 1e-9;
+            }
+            throughputs.push_back(busy_time > 0.0 ? strip.cells_stepped / busy_time : 0.0);
+            
+            strip.timed_cycles.clear();
+            strip.cells_stepped = 0.0;
+        }
+        
+        for(double throughput : throughputs) if(throughput <= 0.0) return;
+        
+        std::vector<int> rows = splitRows(throughputs);
+        
+        int rows_moved = 0;
+        for(size_t i = 0; i < strips.size(); i++) rows_moved = std::max(rows_moved, std::abs(rows[i] - strips[i].rows));
+        
+        // the strips are recreated through the host only when it pays off
+        if(rows_moved <= MULTI_BALANCE_THRESHOLD * height) return;
+        
+        std::vector<unsigned char> cells_data((size_t)width * height);
+        readStrips(cells_data.data());
+        setRows(rows);
+        createBuffers(cells_data.data());
+    }
+
+public:
+    // halo_u rows are exchanged every halo_u generations
+    KernelMulti(const char* kernel_path, int halo_u = 1) : strip_building(0), halo(std::max(1, halo_u)), current(0), parity(0), generations_balanced(0) {
+        loadSource(kernel_path);
+        
+        try {
+            createContexts();
+            buildPrograms();
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    const char* name() const {
+        return "opencl-multi";
+    }
+    
+    // the row splits of the strips, one per device
+    std::vector<int> stripRows() const {
+        std::vector<int> rows;
+        for(const Strip& strip : strips) rows.push_back(strip.rows);
+        return rows;
+    }
+    
+    void setRule(const Rule& rule_u) {
+        requireTwoStates(rule_u, name());
+        if(rule == rule_u) return;
+        rule = rule_u;
+        
+        try {
+            finish();
+            buildPrograms();
+            if(width > 0) setKernelArgs();
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    void load(const unsigned char* cells, int width_u, int height_u) {
+        width = width_u;
+        height = height_u;
+        generation = 0;
+        
+        try {
+            finish();
+            setRows(splitRows(std::vector<double>(strips.size(), 1.0)));
+            createBuffers(cells);
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    void step(unsigned int generations = 1) {
+        try {
+            while(generations > 0) {
+                int g = (int)std::min(generations, (unsigned int)halo);
+                enqueueCycle(g);
+                generations -= g;
+                
+                generations_balanced += g;
+                if(generations_balanced >= MULTI_BALANCE_GENERATIONS) balance();
+            }
+            finish();
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+    
+    void read(unsigned char* cells) {
+        try {
+            readStrips(cells);
+        } catch(cl::Error e) {
+            processError(e);
+        }
+    }
+};
+
+#endif /* kernel_multi_h */
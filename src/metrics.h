@@ -0,0 +1,116 @@
+//
+//  metrics.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef metrics_h
+#define metrics_h
+
+// include the standard libraries
+#include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <iomanip>
+#include <iostream>
+#include <cstdio>
+#include <mutex>
+
+#define METRICS_WINDOW 1024
+
+// the durations of one stage of the frame: the last METRICS_WINDOW samples for the percentiles, the totals since the start
+class StageTimings {
+private:
+    std::vector<double> window; // a ring buffer, next is the oldest sample once it is full
+    size_t next;
+
+public:
+    double sum;
+    unsigned long long count;
+    
+    StageTimings() : next(0), sum(0.0), count(0) {}
+    
+    void record(double seconds) {
+        if(window.size() < METRICS_WINDOW) window.push_back(seconds);
+        else window[next] = seconds;
+        next = (next + 1) % METRICS_WINDOW;
+        
+        sum += seconds;
+        count++;
+    }
+    
+    // the nearest-rank percentile of the window, p in [0, 1]
+    double percentile(double p) const {
+        if(window.empty()) return 0.0;
+        
+        std::vector<double> sorted(window);
+        size_t rank = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+};
+
+// the timings of all the stages by their names, in seconds
+// the OpenCL stages come from the profiling events of the queue, the OpenGL passes from the timer queries, the rest are measured on the host
+// the stages may be recorded from several threads, the renderer and the simulation thread
+class Metrics {
+private:
+    std::map<std::string, StageTimings> stages;
+    mutable std::mutex mutex;
+
+public:
+    void record(const std::string& stage, double seconds) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stages[stage].record(seconds);
+    }
+    
+    // the human-readable table of the stages
+    void dump(std::ostream& output) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        output << "stage, p50_ms, p99_ms, mean_ms, count" << std::endl;
+        for(const auto& stage : stages) {
+            const StageTimings& timings = stage.second;
+            output << stage.first << ", " << timings.percentile(0.5) * 1e3 << ", " << timings.percentile(0.99) * 1e3 << ", " << timings.sum / timings.count * 1e3 << ", " << timings.count << std::endl;
+        }
+    }
+    
+    // the Prometheus text format: a summary per stage, the quantiles over the window, the sum and the count since the start
+    void writePrometheus(std::ostream& output) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        output << std::setprecision(9);
+        output << "# HELP automata_stage_seconds Duration of the stages of a frame." << std::endl;
+        output << "# TYPE automata_stage_seconds summary" << std::endl;
+        
+        for(const auto& stage : stages) {
+            const StageTimings& timings = stage.second;
+            std::string label = "stage=\"" + stage.first + "\"";
+            
+            output << "automata_stage_seconds{" << label << ",quantile=\"0.5\"} " << timings.percentile(0.5) << std::endl;
+            output << "automata_stage_seconds{" << label << ",quantile=\"0.99\"} " << timings.percentile(0.99) << std::endl;
+            output << "automata_stage_seconds_sum{" << label << "} " << timings.sum << std::endl;
+            output << "automata_stage_seconds_count{" << label << "} " << timings.count << std::endl;
+        }
+    }
+    
+    // write to a temporary file and rename it, so that a scraper never reads half a file
+    void writePrometheusFile(const std::string& path) const {
+        std::string path_temp = path + ".tmp";
+        std::ofstream file(path_temp);
+        if(!file) {
+            std::cerr << "ERROR: METRICS: CANNOT WRITE: " << path_temp << std::endl;
+            return;
+        }
+        
+        writePrometheus(file);
+        file.close();
+        
+        if(std::rename(path_temp.c_str(), path.c_str()) != 0) std::cerr << "ERROR: METRICS: CANNOT RENAME: " << path_temp << std::endl;
+    }
+};
+
+#endif /* metrics_h */
@@ -0,0 +1,329 @@
+//
+//  pattern.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef pattern_h
+#define pattern_h
+
+// include the standard libraries
+#include <vector>
+#include <string>
+#include <memory>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+
+#include "engine.h"
+#include "engine_hashlife.h"
+
+#define PATTERN_BUFFER_SIZE (64 * 1024) // the pattern files are read in chunks of this size, whatever their length
+#define PATTERN_LEVEL_MAX HASHLIFE_LEVEL_MAX // the largest Macrocell board is 2^30 x 2^30 cells
+
+// a rule of a pattern file: B3/S23 as in this repository, 23/3 in the older S/B notation, without the topology suffix of Golly (e.g. :T100,100)
+inline Rule parsePatternRule(std::string rule_string) {
+    rule_string = rule_string.substr(0, rule_string.find(':'));
+    
+    std::string rule_trimmed;
+    for(char c : rule_string) if(!isspace((unsigned char)c)) rule_trimmed += c;
+    
+    size_t slash = rule_trimmed.find('/');
+    if(rule_trimmed.find_first_of("BbSs") == std::string::npos && slash != std::string::npos) {
+        rule_trimmed = "B" + rule_trimmed.substr(slash + 1) + "/S" + rule_trimmed.substr(0, slash);
+    }
+    
+    return parseRule(rule_trimmed);
+}
+
+// a pattern file, read lazily: the size and the rule are known once it is opened, the cells are streamed to the engine when it is loaded
+// the runs are given on the board, the pattern sits at (offset_x, offset_y) of it
+class Pattern : public CellRuns {
+protected:
+    std::string path;
+    int offset_x, offset_y;
+    
+    void fail(const char* message) const {
+        std::cerr << "ERROR: PATTERN: " << message << ": " << path << std::endl;
+        exit(-1);
+    }
+    
+    // the run of the pattern on the board, checked against the size given by the file
+    void emitRun(const std::function<void(int, int, int)>& emit, long long x, long long y, long long length) const {
+        if(x < 0 || y < 0 || x + length > width || y >= height) fail("CELLS OUTSIDE OF THE PATTERN SIZE");
+        emit((int)x + offset_x, (int)y + offset_y, (int)length);
+    }
+
+public:
+    int width, height; // the size of the pattern
+    int board_width, board_height;
+    Rule rule;
+    bool rule_found;
+    
+    Pattern(const std::string& path_u) : path(path_u), offset_x(0), offset_y(0), width(0), height(0), board_width(0), board_height(0), rule_found(false) {}
+    virtual ~Pattern() {}
+    
+    // centre the pattern on a board of board_width_u x board_height_u, of the size of the pattern when 0
+    void place(int board_width_u, int board_height_u) {
+        board_width = board_width_u > 0 ? board_width_u : width;
+        board_height = board_height_u > 0 ? board_height_u : height;
+        if(board_width < width || board_height < height) fail("THE PATTERN DOES NOT FIT ON THE BOARD");
+        
+        offset_x = (board_width - width) / 2;
+        offset_y = (board_height - height) / 2;
+    }
+    
+    virtual void load(Engine& engine) {
+        if(board_width == 0) place(0, 0);
+        engine.loadRuns(*this, board_width, board_height);
+    }
+};
+
+// the RLE format of Life: a header "x = 3, y = 3, rule = B3/S23", then the runs, e.g. bo$2bo$3o! - b dead, o alive, $ the end of a row, ! the end
+// the data are parsed as they are read, so a run count may span two chunks of the file
+class PatternRLE : public Pattern {
+private:
+    long data_offset;
+    
+    // "x = 3, y = 3, rule = B3/S23"
+    void parseHeader(const std::string& line) {
+        bool width_found = false, height_found = false;
+        size_t begin = 0;
+        
+        while(begin < line.size()) {
+            size_t end = line.find(',', begin);
+            if(end == std::string::npos) end = line.size();
+            
+            std::string entry = line.substr(begin, end - begin);
+            size_t equals = entry.find('=');
+            if(equals != std::string::npos) {
+                std::string key, value = entry.substr(equals + 1);
+                for(char c : entry.substr(0, equals)) if(!isspace((unsigned char)c)) key += c;
+                
+                if(key == "x") {
+                    width = std::stoi(value);
+                    width_found = true;
+                } else if(key == "y") {
+                    height = std::stoi(value);
+                    height_found = true;
+                } else if(key == "rule") {
+                    rule = parsePatternRule(value);
+                    rule_found = true;
+                }
+            }
+            begin = end + 1;
+        }
+        
+        if(!width_found || !height_found || width < 1 || height < 1) fail("WRONG HEADER");
+    }
+
+public:
+    PatternRLE(const std::string& path_u) : Pattern(path_u), data_offset(0) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if(!file) fail("CANNOT OPEN");
+        
+        // the comment lines come before the header, a line longer than the buffer is read in pieces
+        char line[PATTERN_BUFFER_SIZE];
+        bool line_start = true, header_found = false;
+        std::string header;
+        
+        while(!header_found && fgets(line, sizeof(line), file)) {
+            bool line_end = strchr(line, '\n') != nullptr;
+            
+            if(!line_start || line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+                line_start = line_end;
+                continue;
+            }
+            
+            header += line;
+            if(line_end) header_found = true;
+            line_start = line_end;
+        }
+        
+        if(header.empty()) fail("NO HEADER");
+        parseHeader(header);
+        
+        data_offset = ftell(file);
+        fclose(file);
+    }
+    
+    void forEachRun(const std::function<void(int, int, int)>& emit) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if(!file) fail("CANNOT OPEN");
+        fseek(file, data_offset, SEEK_SET);
+        
+        std::unique_ptr<char[]> buffer(new char[PATTERN_BUFFER_SIZE]);
+        long long count = 0, x = 0, y = 0;
+        bool finished = false, state_prefix = false;
+        
+        while(!finished) {
+            size_t read_size = fread(buffer.get(), 1, PATTERN_BUFFER_SIZE, file);
+            if(read_size == 0) break;
+            
+            for(size_t i = 0; i < read_size && !finished; i++) {
+                char c = buffer[i];
+                
+                if(c >= '0' && c <= '9') {
+                    count = count * 10 + (c - '0');
+                    if(count > (1LL << 32)) fail("RUN TOO LONG");
+                    continue;
+                }
+                if(isspace((unsigned char)c)) continue;
+                
+                long long length = count > 0 ? count : 1;
+                
+                if(c >= 'p' && c <= 'y') {
+                    // the first letter of a state above 24 of the multi-state files, the count belongs to the letter after it
+                    state_prefix = true;
+                    continue;
+                } else if(c == '!') {
+                    finished = true;
+                } else if(c == '$') {
+                    y += length;
+                    x = 0;
+                } else if(c == 'o' || (c == 'A' && !state_prefix)) {
+                    emitRun(emit, x, y, length);
+                    x += length;
+                } else if(isalpha((unsigned char)c) || c == '.') {
+                    // b and . are dead, the dying states of the Generations files are loaded as dead cells
+                    x += length;
+                } else {
+                    fail("UNEXPECTED CHARACTER IN THE RUNS");
+                }
+                
+                count = 0;
+                state_prefix = false;
+            }
+        }
+        
+        fclose(file);
+    }
+};
+
+// the Macrocell format of Golly: the quadtree of the pattern, one node per line, each node referring to the ones before it
+// a leaf is an 8x8 block, e.g. $.*$..*$***$ (. dead, * alive, $ the end of a row), a node above is "level nw ne sw se" with 0 for an empty child
+// the lines are read one at a time, only the tree is kept - on HashLife the tree is joined as it is, the other engines get the runs of its leaves
+class PatternMacrocell : public Pattern {
+private:
+    std::vector<QuadtreeNode> tree;
+    
+    uint64_t parseLeaf(const char* line) const {
+        uint64_t leaf = 0;
+        int x = 0, y = 0;
+        
+        for(const char* c = line; *c && *c != '\n' && *c != '\r'; c++) {
+            if(*c == '$') {
+                x = 0;
+                y++;
+            } else if(*c == '*' || *c == '.') {
+                if(x > 7 || y > 7) fail("LEAF LARGER THAN 8x8");
+                if(*c == '*') leaf |= 1ULL << (y * 8 + x);
+                x++;
+            } else {
+                fail("UNEXPECTED CHARACTER IN A LEAF");
+            }
+        }
+        
+        return leaf;
+    }
+    
+    void emitNode(const std::function<void(int, int, int)>& emit, uint32_t index, long long x0, long long y0) const {
+        if(index == 0) return;
+        const QuadtreeNode& node = tree[index];
+        
+        if(node.level == 3) {
+            for(int y = 0; y < 8; y++) {
+                unsigned int row = (unsigned int)(node.leaf >> (y * 8)) & 0xFF;
+                
+                for(int x = 0; x < 8;) {
+                    if(!((row >> x) & 1)) {
+                        x++;
+                        continue;
+                    }
+                    
+                    int x_begin = x;
+                    while(x < 8 && ((row >> x) & 1)) x++;
+                    emitRun(emit, x0 + x_begin, y0 + y, x - x_begin);
+                }
+            }
+            return;
+        }
+        
+        long long half = 1LL << (node.level - 1);
+        emitNode(emit, node.nw, x0, y0);
+        emitNode(emit, node.ne, x0 + half, y0);
+        emitNode(emit, node.sw, x0, y0 + half);
+        emitNode(emit, node.se, x0 + half, y0 + half);
+    }
+
+public:
+    PatternMacrocell(const std::string& path_u) : Pattern(path_u) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if(!file) fail("CANNOT OPEN");
+        
+        char line[PATTERN_BUFFER_SIZE];
+        if(!fgets(line, sizeof(line), file) || strncmp(line, "[M2]", 4) != 0) fail("NOT A MACROCELL FILE");
+        
+        tree.push_back({0, 0, 0, 0, 0, 0}); // the empty node
+        
+        while(fgets(line, sizeof(line), file)) {
+            if(line[0] == '#') {
+                if(line[1] == 'R') {
+                    rule = parsePatternRule(std::string(line + 2, strcspn(line + 2, "\r\n")));
+                    rule_found = true;
+                }
+                continue;
+            }
+            if(line[0] == '\n' || line[0] == '\r') continue;
+            
+            QuadtreeNode node = {3, 0, 0, 0, 0, 0};
+            if(line[0] == '.' || line[0] == '*' || line[0] == '$') {
+                node.leaf = parseLeaf(line);
+            } else {
+                unsigned long long children[4];
+                if(sscanf(line, "%u %llu %llu %llu %llu", &node.level, &children[0], &children[1], &children[2], &children[3]) != 5) fail("WRONG NODE");
+                if(node.level == 1) fail("ONLY THE TWO-STATE MACROCELL FILES ARE SUPPORTED");
+                if(node.level < 4 || node.level > PATTERN_LEVEL_MAX) fail("WRONG NODE LEVEL");
+                
+                // the children are nodes of the level below, defined before this one
+                for(int i = 0; i < 4; i++) {
+                    if(children[i] >= tree.size() || (children[i] > 0 && tree[children[i]].level != node.level - 1)) fail("WRONG NODE CHILD");
+                }
+                node.nw = (uint32_t)children[0];
+                node.ne = (uint32_t)children[1];
+                node.sw = (uint32_t)children[2];
+                node.se = (uint32_t)children[3];
+            }
+            tree.push_back(node);
+        }
+        fclose(file);
+        
+        if(tree.size() < 2) fail("NO NODES");
+        width = height = 1 << tree.back().level;
+    }
+    
+    void forEachRun(const std::function<void(int, int, int)>& emit) {
+        emitNode(emit, (uint32_t)tree.size() - 1, 0, 0);
+    }
+    
+    // HashLife takes the tree as it is, when the board is the square of the pattern
+    void load(Engine& engine) {
+        if(board_width == 0) place(0, 0);
+        
+        EngineHashLife* engine_hashlife = dynamic_cast<EngineHashLife*>(&engine);
+        if(engine_hashlife && board_width == width && board_height == height) engine_hashlife->loadQuadtree(tree);
+        else Pattern::load(engine);
+    }
+};
+
+// open a pattern by the extension of its file, .mc for Macrocell and RLE otherwise
+inline Pattern* openPattern(const std::string& path) {
+    if(path.size() > 3 && path.compare(path.size() - 3, 3, ".mc") == 0) return new PatternMacrocell(path);
+    return new PatternRLE(path);
+}
+
+#endif /* pattern_h */
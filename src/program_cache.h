@@ -0,0 +1,148 @@
+//
+//  program_cache.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef program_cache_h
+#define program_cache_h
+
+// include the standard libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// include the OpenCL library (C++ binding)
+#define __CL_ENABLE_EXCEPTIONS
+#define CL_HPP_TARGET_OPENCL_VERSION 120
+#define CL_HPP_MINIMUM_OPENCL_VERSION 120
+#include "cl2.hpp"
+
+#define PROGRAM_CACHE_MAGIC 0x4C434141u // "AACL"
+#define PROGRAM_CACHE_VERSION 1u
+
+// the compiled programs kept on disk, one file per source, build options, device and driver
+// a file holds its whole key and a hash of the binary, so that a stale or a corrupt entry is never loaded - the program is then built from the source and the entry written again
+// the entries are written to a temporary file of the process and renamed, so that the processes sharing the directory only ever see whole entries
+class ProgramCache {
+private:
+    std::string directory; // empty to disable the cache
+    
+    static uint64_t hash(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+        for(size_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+    
+    static std::string hexString(uint64_t value) {
+        char buffer[17];
+        snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)value);
+        return buffer;
+    }
+    
+    static std::string entryKey(cl::Device& device, const std::string& source, const std::string& options) {
+        std::string key = device.getInfo<CL_DEVICE_NAME>() + "\n" + device.getInfo<CL_DRIVER_VERSION>() + "\n" + options + "\n";
+        return key + hexString(hash((const unsigned char*)source.data(), source.size()));
+    }
+    
+    std::string entryPath(const std::string& key) const {
+        return directory + "/" + hexString(hash((const unsigned char*)key.data(), key.size())) + ".bin";
+    }
+    
+    template<typename T>
+    static bool readValue(std::ifstream& file, T& value) {
+        return (bool)file.read((char*)&value, sizeof(T));
+    }
+    
+    template<typename T>
+    static void writeValue(std::ofstream& file, const T& value) {
+        file.write((const char*)&value, sizeof(T));
+    }
+    
+    // false when the entry is missing, or is not the one of the key
+    bool load(const std::string& key, std::vector<unsigned char>& binary) const {
+        std::ifstream file(entryPath(key), std::ios::in | std::ios::binary);
+        if(!file) return false;
+        
+        uint32_t magic, version;
+        uint64_t key_length, binary_size, binary_hash;
+        if(!readValue(file, magic) || !readValue(file, version) || magic != PROGRAM_CACHE_MAGIC || version != PROGRAM_CACHE_VERSION) return false;
+        
+        if(!readValue(file, key_length) || key_length != key.size()) return false;
+        std::string key_stored(key_length, '\0');
+        if(!file.read(&key_stored[0], key_length) || key_stored != key) return false;
+        
+        if(!readValue(file, binary_size) || binary_size == 0 || binary_size > (1ULL << 30)) return false;
+        binary.resize(binary_size);
+        if(!file.read((char*)binary.data(), binary_size) || !readValue(file, binary_hash)) return false;
+        
+        return binary_hash == hash(binary.data(), binary.size());
+    }
+    
+    void store(const std::string& key, const std::vector<unsigned char>& binary) const {
+        mkdir(directory.c_str(), 0755); // fails harmlessly when it exists
+        
+        std::string path = entryPath(key);
+        std::string path_temp = path + "." + std::to_string(getpid()) + ".tmp";
+        
+        std::ofstream file(path_temp, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!file) return; // a cache that cannot be written only costs the next start its build
+        
+        writeValue(file, (uint32_t)PROGRAM_CACHE_MAGIC);
+        writeValue(file, (uint32_t)PROGRAM_CACHE_VERSION);
+        writeValue(file, (uint64_t)key.size());
+        file.write(key.data(), key.size());
+        writeValue(file, (uint64_t)binary.size());
+        file.write((const char*)binary.data(), binary.size());
+        writeValue(file, hash(binary.data(), binary.size()));
+        file.close();
+        
+        if(!file || std::rename(path_temp.c_str(), path.c_str()) != 0) std::remove(path_temp.c_str());
+    }
+
+public:
+    ProgramCache(const std::string& directory_u = "cache") : directory(directory_u) {}
+    
+    // build the program for the device from the cached binary, or from the source when there is none, and cache its binary
+    // program is assigned before the build, so that the callers can read its build log when the build throws
+    void build(cl::Program& program, cl::Context& context, cl::Device& device, const std::string& source, const std::string& options) {
+        std::string key;
+        
+        if(!directory.empty()) {
+            key = entryKey(device, source, options);
+            
+            std::vector<unsigned char> binary;
+            if(load(key, binary)) {
+                try {
+                    program = cl::Program(context, {device}, cl::Program::Binaries(1, binary));
+                    program.build({device}, options.c_str());
+                    return;
+                } catch(cl::Error e) {
+                    // the driver refused the binary, the source build below replaces the entry
+                }
+            }
+        }
+        
+        cl::Program::Sources sources;
+        sources.push_back({source.c_str(), source.length()});
+        
+        program = cl::Program(context, sources);
+        program.build({device}, options.c_str());
+        
+        if(!directory.empty()) {
+            std::vector<std::vector<unsigned char>> binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+            if(binaries.size() == 1 && !binaries[0].empty()) store(key, binaries[0]);
+        }
+    }
+};
+
+#endif /* program_cache_h */
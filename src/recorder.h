@@ -0,0 +1,256 @@
+//
+//  recorder.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef recorder_h
+#define recorder_h
+
+// include the standard libraries
+#include <vector>
+#include <deque>
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <sys/stat.h>
+
+// include the OpenGL libraries
+#include <GL/glew.h>
+
+#include "metrics.h"
+
+#define RECORDER_PBOS 3 // frames read back by the GPU at once, a frame is copied out two frames after its readback was issued
+#define RECORDER_QUEUE_MAX 64 // frames waiting for the writer, the renderer waits rather than drops a frame when the writer falls this far behind
+#define RECORDER_FENCE_TIMEOUT 1000000000ULL // ns
+
+// records every frame of the renderer: the pixels are read into a ring of pixel buffer objects without waiting for the GPU, copied out once their fence has signalled, and written by a background thread
+// the frames go either to a numbered sequence of TGA files in a directory or, as raw BGR frames bottom row first, to the standard input of an encoder command
+class Recorder {
+private:
+    struct Frame {
+        std::vector<char> pixels;
+        short width, height;
+        unsigned long long index;
+    };
+    
+    // the ring of the readbacks, pbos_pending of them issued and not yet copied out, the oldest at pbo_oldest
+    GLuint pbos[RECORDER_PBOS];
+    GLsync fences[RECORDER_PBOS];
+    short pbo_width, pbo_height;
+    int pbo_oldest, pbos_pending;
+    
+    std::string directory;
+    std::string pipe_command;
+    FILE* pipe;
+    
+    unsigned long long frames_captured, frames_written;
+    Metrics* metrics;
+    
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Frame> queue;
+    std::vector<std::vector<char>> buffers_free;
+    bool stopping, failed;
+    
+    void writeFrame(const Frame& frame) {
+        if(pipe) {
+            if(fwrite(frame.pixels.data(), 1, frame.pixels.size(), pipe) != frame.pixels.size()) failed = true;
+            return;
+        }
+        
+        char name[32];
+        snprintf(name, sizeof(name), "/frame_%06llu.tga", frame.index);
+        
+        FILE* file = fopen((directory + name).c_str(), "wb");
+        if(!file) {
+            failed = true;
+            return;
+        }
+        
+        short TGA_header[] = {0, 2, 0, 0, 0, 0, frame.width, frame.height, 24};
+        fwrite(TGA_header, sizeof(short), 9, file);
+        if(fwrite(frame.pixels.data(), 1, frame.pixels.size(), file) != frame.pixels.size()) failed = true;
+        fclose(file);
+    }
+    
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        
+        while(true) {
+            condition.wait(lock, [this] { return !queue.empty() || stopping; });
+            if(queue.empty()) return;
+            
+            Frame frame = std::move(queue.front());
+            queue.pop_front();
+            
+            lock.unlock();
+            writeFrame(frame);
+            lock.lock();
+            
+            buffers_free.push_back(std::move(frame.pixels));
+            frames_written++;
+            condition.notify_all();
+        }
+    }
+    
+    void createPBOs(short width, short height) {
+        pbo_width = width;
+        pbo_height = height;
+        
+        glGenBuffers(RECORDER_PBOS, pbos);
+        for(int i = 0; i < RECORDER_PBOS; i++) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, 3 * (size_t)width * height, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        
+        pbo_oldest = 0;
+        pbos_pending = 0;
+    }
+    
+    void deletePBOs() {
+        if(pbo_width == 0) return;
+        
+        glDeleteBuffers(RECORDER_PBOS, pbos);
+        pbo_width = pbo_height = 0;
+    }
+    
+    // copy the oldest readback out of its buffer and queue it for the writer, false if the GPU has not finished it and wait is false
+    bool collectOldest(bool wait) {
+        GLsync fence = fences[pbo_oldest];
+        GLenum status = glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? RECORDER_FENCE_TIMEOUT : 0);
+        if(status == GL_TIMEOUT_EXPIRED && !wait) return false;
+        if(status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED) {
+            std::cerr << "ERROR: RECORDER: THE READBACK OF A FRAME DID NOT FINISH" << std::endl;
+            exit(-1);
+        }
+        glDeleteSync(fence);
+        
+        Frame frame;
+        frame.width = pbo_width;
+        frame.height = pbo_height;
+        frame.index = frames_captured - pbos_pending;
+        
+        {
+            // the writer thread hands back the buffers of the frames it has written
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return queue.size() < RECORDER_QUEUE_MAX; });
+            if(!buffers_free.empty()) {
+                frame.pixels = std::move(buffers_free.back());
+                buffers_free.pop_back();
+            }
+        }
+        frame.pixels.resize(3 * (size_t)pbo_width * pbo_height);
+        
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo_oldest]);
+        void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame.pixels.size(), GL_MAP_READ_BIT);
+        if(pixels) memcpy(frame.pixels.data(), pixels, frame.pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(frame));
+        }
+        condition.notify_all();
+        
+        pbo_oldest = (pbo_oldest + 1) % RECORDER_PBOS;
+        pbos_pending--;
+        return true;
+    }
+
+public:
+    // directory_u for an image sequence, or pipe_command_u (e.g. an ffmpeg command reading raw video from its standard input) when it is not empty
+    Recorder(const std::string& directory_u, const std::string& pipe_command_u = "") : pbo_width(0), pbo_height(0), pbo_oldest(0), pbos_pending(0), directory(directory_u), pipe_command(pipe_command_u), pipe(nullptr), frames_captured(0), frames_written(0), metrics(nullptr), stopping(false), failed(false) {
+        if(pipe_command.empty()) mkdir(directory.c_str(), 0755); // fails harmlessly when it exists
+        thread = std::thread(&Recorder::run, this);
+    }
+    
+    // every frame captured is written before the recorder is gone
+    ~Recorder() {
+        while(pbos_pending > 0) collectOldest(true);
+        deletePBOs();
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        thread.join();
+        
+        if(pipe) pclose(pipe);
+        if(failed) std::cerr << "ERROR: RECORDER: SOME FRAMES COULD NOT BE WRITTEN" << std::endl;
+        std::cout << "SUCCESS: RECORDER: FRAMES WRITTEN: " << frames_written << std::endl;
+    }
+    
+    // record the time of every capture to metrics, nullptr to stop
+    void setMetrics(Metrics* metrics_u) {
+        metrics = metrics_u;
+    }
+    
+    // queue the readback of the framebuffer bound for reading, the call returns before the GPU has read it
+    void capture(short width, short height) {
+        auto capture_start = std::chrono::steady_clock::now();
+        
+        if(width != pbo_width || height != pbo_height) {
+            if(pipe) {
+                std::cerr << "ERROR: RECORDER: THE FRAMES OF A VIDEO CANNOT CHANGE SIZE" << std::endl;
+                return;
+            }
+            
+            // the frames in flight keep their old size
+            while(pbos_pending > 0) collectOldest(true);
+            deletePBOs();
+            createPBOs(width, height);
+        }
+        
+        if(!pipe_command.empty() && !pipe) {
+            // the size of the frames is known only now, the command gets it in place of {width} and {height}
+            std::string command = pipe_command;
+            for(const char* key : {"{width}", "{height}"}) {
+                size_t position;
+                while((position = command.find(key)) != std::string::npos) command.replace(position, strlen(key), std::to_string(key[1] == 'w' ? width : height));
+            }
+            
+            signal(SIGPIPE, SIG_IGN); // an encoder that quits fails the writes instead of the process
+            pipe = popen(command.c_str(), "w");
+            if(!pipe) {
+                std::cerr << "ERROR: RECORDER: CANNOT START: " << command << std::endl;
+                exit(-1);
+            }
+        }
+        
+        // take the finished readbacks, and wait for the oldest one only when the ring is full
+        while(pbos_pending > 0 && collectOldest(false));
+        if(pbos_pending == RECORDER_PBOS) collectOldest(true);
+        
+        int pbo = (pbo_oldest + pbos_pending) % RECORDER_PBOS;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_BGR, GL_UNSIGNED_BYTE, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        
+        fences[pbo] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        pbos_pending++;
+        frames_captured++;
+        
+        if(metrics) metrics->record("record_capture", std::chrono::duration<double>(std::chrono::steady_clock::now() - capture_start).count());
+    }
+    
+    unsigned long long framesCaptured() const {
+        return frames_captured;
+    }
+};
+
+#endif /* recorder_h */
@@ -0,0 +1,342 @@
+//
+//  rule.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef rule_h
+#define rule_h
+
+// include the standard libraries
+#include <cstdint>
+#include <string>
+#include <sstream>
+#include <cctype>
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <cmath>
+
+// Life-like rules: bit n of the birth (survival) mask is set when a dead (alive) cell with n alive neighbours lives in the next generation
+#define RULE_LIFE_BIRTH (1u << 3)
+#define RULE_LIFE_SURVIVAL ((1u << 2) | (1u << 3))
+#define RULE_HIGHLIFE_BIRTH ((1u << 3) | (1u << 6))
+#define RULE_DAYNIGHT_BIRTH ((1u << 3) | (1u << 6) | (1u << 7) | (1u << 8))
+#define RULE_DAYNIGHT_SURVIVAL ((1u << 3) | (1u << 4) | (1u << 6) | (1u << 7) | (1u << 8))
+#define RULE_SEEDS_BIRTH (1u << 2)
+
+// template argument of the kernels that read the rule at run time instead of having it compiled in
+#define RULE_DYNAMIC 0xFFFFFFFFu
+
+#define RULE_STATES_MAX 256
+
+// Generations rules (B/S/C) have states - 2 dying states: an alive cell that does not survive goes through the states 2, 3, ... states - 1 and back to 0,
+// the dying cells neither count as neighbours nor can be born, e.g. B2/S/C3 (Brian's Brain) or B2/S345/C4 (Star Wars)
+struct Rule {
+    uint32_t birth, survival;
+    uint32_t states; // 2 for the Life-like rules
+    
+    Rule(uint32_t birth_u = RULE_LIFE_BIRTH, uint32_t survival_u = RULE_LIFE_SURVIVAL, uint32_t states_u = 2) : birth(birth_u), survival(survival_u), states(states_u) {}
+    
+    bool operator==(const Rule& other) const {
+        return birth == other.birth && survival == other.survival && states == other.states;
+    }
+    
+    bool operator!=(const Rule& other) const {
+        return !(*this == other);
+    }
+};
+
+constexpr bool ruleIsLife(uint32_t birth, uint32_t survival) {
+    return birth == RULE_LIFE_BIRTH && survival == RULE_LIFE_SURVIVAL;
+}
+
+// the next state of a cell, without branching on the rule
+inline unsigned char ruleNext(uint32_t birth, uint32_t survival, unsigned char alive, int counter) {
+    return ((alive ? survival : birth) >> counter) & 1u;
+}
+
+// the transitions of all the states as one table: transitions[state * 9 + counter] is the next state, counting only the alive (state 1) neighbours
+inline std::vector<unsigned char> ruleTransitions(const Rule& rule) {
+    std::vector<unsigned char> transitions(rule.states * 9);
+    
+    for(uint32_t state = 0; state < rule.states; state++) for(int counter = 0; counter < 9; counter++) {
+        unsigned char next;
+        if(state == 0) next = (rule.birth >> counter) & 1u;
+        else if(state == 1) next = ((rule.survival >> counter) & 1u) ? 1 : (rule.states > 2 ? 2 : 0);
+        else next = state + 1 < rule.states ? state + 1 : 0;
+        
+        transitions[state * 9 + counter] = next;
+    }
+    
+    return transitions;
+}
+
+// lookup tables indexed by the neighbour count, padded to 16 entries and repeated 4 times for the byte shuffles of the SIMD kernels (which work within 128-bit lanes)
+struct RuleTable {
+    unsigned char birth[64], survival[64];
+    
+    RuleTable(const Rule& rule = Rule()) {
+        for(int i = 0; i < 64; i++) {
+            birth[i] = (i & 15) < 9 ? (rule.birth >> (i & 15)) & 1u : 0;
+            survival[i] = (i & 15) < 9 ? (rule.survival >> (i & 15)) & 1u : 0;
+        }
+    }
+};
+
+// parse a rule in the B/S notation, e.g. B3/S23 for Life or B36/S23 for HighLife, with an optional number of states for the Generations rules, e.g. B2/S/C3
+// the order and the case of the letters do not matter
+inline Rule parseRule(const std::string& rule_string) {
+    Rule rule(0, 0, 0);
+    char key = 0;
+    bool birth_found = false, survival_found = false, states_found = false, valid = true;
+    
+    for(char c : rule_string) {
+        char c_upper = (char)toupper(c);
+        
+        if(c_upper == 'B' || c_upper == 'S' || c_upper == 'C') {
+            bool& found = (c_upper == 'B') ? birth_found : (c_upper == 'S' ? survival_found : states_found);
+            valid = !found;
+            found = true;
+            key = c_upper;
+        } else if(c == '/') {
+            continue;
+        } else if(key == 'C' && c >= '0' && c <= '9') {
+            rule.states = rule.states * 10 + (c - '0');
+            valid = rule.states <= RULE_STATES_MAX;
+        } else if(key != 0 && c >= '0' && c <= '8') {
+            (key == 'B' ? rule.birth : rule.survival) |= 1u << (c - '0');
+        } else {
+            valid = false;
+        }
+        
+        if(!valid) break;
+    }
+    
+    if(!states_found) rule.states = 2;
+    
+    if(!valid || !birth_found || !survival_found || rule.states < 2) {
+        std::cerr << "ERROR: RULE: CANNOT PARSE RULE: " << rule_string << " (EXPECTED E.G. B3/S23 OR B2/S/C3)" << std::endl;
+        exit(-1);
+    }
+    
+    return rule;
+}
+
+inline std::string ruleString(const Rule& rule) {
+    std::string rule_string = "B";
+    for(int i = 0; i < 9; i++) if((rule.birth >> i) & 1u) rule_string += (char)('0' + i);
+    rule_string += "/S";
+    for(int i = 0; i < 9; i++) if((rule.survival >> i) & 1u) rule_string += (char)('0' + i);
+    if(rule.states > 2) rule_string += "/C" + std::to_string(rule.states);
+    return rule_string;
+}
+
+// pick the kernel compiled for the rule, Specialization<BIRTH, SURVIVAL>::kernel(args...) returns the kernel specialized for the given masks
+// the common rules get their own instantiation, any other rule falls back to the RULE_DYNAMIC one which reads the rule at run time
+template<template<uint32_t, uint32_t> class Specialization, typename... Args>
+inline typename Specialization<RULE_DYNAMIC, RULE_DYNAMIC>::Kernel specializeRule(const Rule& rule, Args... args) {
+    if(rule == Rule(RULE_LIFE_BIRTH, RULE_LIFE_SURVIVAL)) return Specialization<RULE_LIFE_BIRTH, RULE_LIFE_SURVIVAL>::kernel(args...);
+    if(rule == Rule(RULE_HIGHLIFE_BIRTH, RULE_LIFE_SURVIVAL)) return Specialization<RULE_HIGHLIFE_BIRTH, RULE_LIFE_SURVIVAL>::kernel(args...);
+    if(rule == Rule(RULE_DAYNIGHT_BIRTH, RULE_DAYNIGHT_SURVIVAL)) return Specialization<RULE_DAYNIGHT_BIRTH, RULE_DAYNIGHT_SURVIVAL>::kernel(args...);
+    if(rule == Rule(RULE_SEEDS_BIRTH, 0)) return Specialization<RULE_SEEDS_BIRTH, 0>::kernel(args...);
+    return Specialization<RULE_DYNAMIC, RULE_DYNAMIC>::kernel(args...);
+}
+
+// Larger-than-Life rules in the notation of Golly, e.g. R5,C0,M1,S34..58,B34..45,NM (Bosco's rule)
+// the neighbourhood is the (2R + 1)^2 square (NM, Moore) or the diamond |dx| + |dy| <= R (NN, von Neumann), the centre cell counts if M1
+#define RULE_LTL_RADIUS_MAX 64
+
+struct RuleLtL {
+    int radius;
+    bool von_neumann, centre;
+    int birth_min, birth_max, survival_min, survival_max;
+    
+    RuleLtL() : radius(1), von_neumann(false), centre(false), birth_min(3), birth_max(3), survival_min(2), survival_max(3) {}
+};
+
+inline RuleLtL parseRuleLtL(const std::string& rule_string) {
+    RuleLtL rule;
+    bool valid = true;
+    
+    size_t begin = 0;
+    while(valid && begin < rule_string.size()) {
+        size_t end = rule_string.find(',', begin);
+        if(end == std::string::npos) end = rule_string.size();
+        std::string token = rule_string.substr(begin, end - begin);
+        begin = end + 1;
+        
+        if(token.size() < 2) {
+            valid = false;
+            break;
+        }
+        
+        char key = (char)toupper(token[0]);
+        std::string value = token.substr(1);
+        
+        if(key == 'N') {
+            char neighbourhood = (char)toupper(value[0]);
+            valid = value.size() == 1 && (neighbourhood == 'M' || neighbourhood == 'N');
+            rule.von_neumann = neighbourhood == 'N';
+            continue;
+        }
+        
+        // the ranges are given as min..max, the other values are single numbers
+        size_t dots = value.find("..");
+        int value_min = -1, value_max = -1;
+        if(value.find_first_not_of("0123456789.") != std::string::npos) valid = false;
+        else if(dots == std::string::npos) value_min = value_max = atoi(value.c_str());
+        else if(dots > 0 && dots + 2 < value.size()) {
+            value_min = atoi(value.substr(0, dots).c_str());
+            value_max = atoi(value.substr(dots + 2).c_str());
+        } else valid = false;
+        
+        if(key == 'R') rule.radius = value_min;
+        else if(key == 'C') valid = valid && value_min <= 2; // two states only
+        else if(key == 'M') rule.centre = value_min == 1;
+        else if(key == 'S') {
+            rule.survival_min = value_min;
+            rule.survival_max = value_max;
+        } else if(key == 'B') {
+            rule.birth_min = value_min;
+            rule.birth_max = value_max;
+        } else valid = false;
+    }
+    
+    if(!valid || rule.radius < 1 || rule.radius > RULE_LTL_RADIUS_MAX || rule.birth_min < 0 || rule.survival_min < 0) {
+        std::cerr << "ERROR: RULE: CANNOT PARSE LARGER-THAN-LIFE RULE: " << rule_string << " (EXPECTED E.G. R5,C0,M1,S34..58,B34..45,NM)" << std::endl;
+        exit(-1);
+    }
+    
+    return rule;
+}
+
+inline std::string ruleStringLtL(const RuleLtL& rule) {
+    return "R" + std::to_string(rule.radius) + ",C0,M" + (rule.centre ? "1" : "0") + ",S" + std::to_string(rule.survival_min) + ".." + std::to_string(rule.survival_max)
+         + ",B" + std::to_string(rule.birth_min) + ".." + std::to_string(rule.birth_max) + ",N" + (rule.von_neumann ? "N" : "M");
+}
+
+// a Life-like rule as a radius 1 Larger-than-Life rule, possible when its birth and survival counts are ranges (e.g. Life, but not HighLife)
+inline bool ruleToLtL(const Rule& rule, RuleLtL& rule_ltl) {
+    if(rule.states > 2) return false;
+    
+    int ranges[2][2];
+    uint32_t masks[2] = {rule.birth, rule.survival};
+    
+    for(int i = 0; i < 2; i++) {
+        if(masks[i] == 0) return false;
+        
+        ranges[i][0] = 0;
+        while(!((masks[i] >> ranges[i][0]) & 1u)) ranges[i][0]++;
+        ranges[i][1] = ranges[i][0];
+        while((masks[i] >> (ranges[i][1] + 1)) & 1u) ranges[i][1]++;
+        
+        if(masks[i] >> (ranges[i][1] + 1)) return false;
+    }
+    
+    rule_ltl = RuleLtL();
+    rule_ltl.birth_min = ranges[0][0];
+    rule_ltl.birth_max = ranges[0][1];
+    rule_ltl.survival_min = ranges[1][0];
+    rule_ltl.survival_max = ranges[1][1];
+    return true;
+}
+
+// Lenia rules: continuous states in [0, 1], the potential U is the convolution of the board with a smooth ring-shaped kernel of radius R
+// and every generation adds G(U) / T to the state, G(u) = 2 exp(-(u - m)^2 / (2 s^2)) - 1, e.g. R13,T10,M0.15,S0.015,B1 (Orbium)
+// B lists the heights of the concentric rings of the kernel, e.g. B1/0.5 for two rings
+#define RULE_LENIA_RADIUS_MAX 1024
+
+struct RuleLenia {
+    int radius;
+    float time_steps, mu, sigma;
+    std::vector<float> peaks;
+    
+    RuleLenia() : radius(13), time_steps(10.0f), mu(0.15f), sigma(0.015f), peaks(1, 1.0f) {}
+};
+
+inline RuleLenia parseRuleLenia(const std::string& rule_string) {
+    RuleLenia rule;
+    bool valid = true;
+    
+    size_t begin = 0;
+    while(valid && begin < rule_string.size()) {
+        size_t end = rule_string.find(',', begin);
+        if(end == std::string::npos) end = rule_string.size();
+        std::string token = rule_string.substr(begin, end - begin);
+        begin = end + 1;
+        
+        if(token.size() < 2 || token.find_first_not_of("0123456789./", 1) != std::string::npos) {
+            valid = false;
+            break;
+        }
+        
+        char key = (char)toupper(token[0]);
+        std::string value = token.substr(1);
+        
+        if(key == 'B') {
+            // the ring heights are separated by slashes
+            rule.peaks.clear();
+            size_t peak_begin = 0;
+            while(peak_begin <= value.size()) {
+                size_t peak_end = value.find('/', peak_begin);
+                if(peak_end == std::string::npos) peak_end = value.size();
+                if(peak_end == peak_begin) valid = false;
+                else rule.peaks.push_back((float)atof(value.substr(peak_begin, peak_end - peak_begin).c_str()));
+                peak_begin = peak_end + 1;
+            }
+        } else if(value.find('/') != std::string::npos) valid = false;
+        else if(key == 'R') rule.radius = atoi(value.c_str());
+        else if(key == 'T') rule.time_steps = (float)atof(value.c_str());
+        else if(key == 'M') rule.mu = (float)atof(value.c_str());
+        else if(key == 'S') rule.sigma = (float)atof(value.c_str());
+        else valid = false;
+    }
+    
+    if(!valid || rule.radius < 1 || rule.radius > RULE_LENIA_RADIUS_MAX || rule.time_steps <= 0.0f || rule.sigma <= 0.0f || rule.peaks.empty()) {
+        std::cerr << "ERROR: RULE: CANNOT PARSE LENIA RULE: " << rule_string << " (EXPECTED E.G. R13,T10,M0.15,S0.015,B1)" << std::endl;
+        exit(-1);
+    }
+    
+    return rule;
+}
+
+inline std::string ruleStringLenia(const RuleLenia& rule) {
+    std::ostringstream rule_stream;
+    rule_stream << "R" << rule.radius << ",T" << rule.time_steps << ",M" << rule.mu << ",S" << rule.sigma << ",B";
+    for(size_t i = 0; i < rule.peaks.size(); i++) rule_stream << (i > 0 ? "/" : "") << rule.peaks[i];
+    return rule_stream.str();
+}
+
+inline float leniaGrowth(float potential, float mu, float sigma) {
+    float distance = (potential - mu) / sigma;
+    return 2.0f * expf(-0.5f * distance * distance) - 1.0f;
+}
+
+// the kernel of the rule centred on the cell (0, 0) of a width x height board, wrapped around the edges and normalised to sum to 1
+// every ring is the bump exp(4 - 1 / (r (1 - r))) over its share of the radius
+inline std::vector<float> leniaWeights(const RuleLenia& rule, int width, int height) {
+    std::vector<float> weights((size_t)width * height, 0.0f);
+    double weights_sum = 0.0;
+    
+    for(int dy = -rule.radius; dy <= rule.radius; dy++) for(int dx = -rule.radius; dx <= rule.radius; dx++) {
+        double distance = sqrt((double)(dx * dx + dy * dy)) / rule.radius * rule.peaks.size();
+        if(distance >= rule.peaks.size()) continue;
+        
+        int ring = (int)distance;
+        double r = distance - ring;
+        if(r <= 0.0) continue;
+        
+        double weight = rule.peaks[ring] * exp(4.0 - 1.0 / (r * (1.0 - r)));
+        weights[(size_t)((dy % height + height) % height) * width + (dx % width + width) % width] += (float)weight;
+        weights_sum += weight;
+    }
+    
+    if(weights_sum > 0.0) for(float& weight : weights) weight = (float)(weight / weights_sum);
+    
+    return weights;
+}
+
+#endif /* rule_h */
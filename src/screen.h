@@ -13,6 +13,9 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "metrics.h"
+#include "recorder.h"
+
 class Screen {
 private:
     unsigned int scr_width, scr_height;
@@ -25,6 +28,12 @@ private:
     
     unsigned int VBO, VAO, EBO, FBO;
     
+    // timer queries of the two passes, a pair per frame for two frames, so that the results are read two frames later without stalling
+    Metrics* metrics;
+    GLuint queries[2][2];
+    bool queries_issued[2];
+    int query_frame;
+    
     
     void createFramebuffer() {
         glGenFramebuffers(1, &FBO);
@@ -85,6 +94,21 @@ private:
         glViewport(0, 0, scr_width, scr_height);
     }
 
+    void recordQueries() {
+        if(!queries_issued[query_frame]) return;
+        queries_issued[query_frame] = false;
+        
+        GLint available = 0;
+        glGetQueryObjectiv(queries[query_frame][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available) return; // the frame is dropped from the timings rather than waited for
+        
+        GLuint64 automata_time, screen_time;
+        glGetQueryObjectui64v(queries[query_frame][0], GL_QUERY_RESULT, &automata_time);
+        glGetQueryObjectui64v(queries[query_frame][1], GL_QUERY_RESULT, &screen_time);
+        metrics->record("gl_automata_pass", automata_time * 1e-9);
+        metrics->record("gl_screen_pass", screen_time * 1e-9);
+    }
+
 public:
     Shader automata_shader;
     
@@ -96,22 +120,45 @@ public:
         
         createScreen();
         createFramebuffer();
+        
+        metrics = nullptr;
+        glGenQueries(4, &queries[0][0]);
+        queries_issued[0] = queries_issued[1] = false;
+        query_frame = 0;
     }
     
     ~Screen() {
+        glDeleteQueries(4, &queries[0][0]);
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
         glDeleteBuffers(1, &EBO);
         glDeleteFramebuffers(1, &FBO);
     }
     
+    // time the passes of draw() on the GPU from now on, nullptr to stop
+    void setMetrics(Metrics* metrics_u) {
+        metrics = metrics_u;
+        queries_issued[0] = queries_issued[1] = false;
+    }
+    
     void draw() {
+        if(metrics) {
+            query_frame = 1 - query_frame;
+            recordQueries();
+            glBeginQuery(GL_TIME_ELAPSED, queries[query_frame][0]);
+        }
+        
         bind();
         automata_shader.use();
         
         glBindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
         
+        if(metrics) {
+            glEndQuery(GL_TIME_ELAPSED);
+            glBeginQuery(GL_TIME_ELAPSED, queries[query_frame][1]);
+        }
+        
         unbind();
         screen_shader.use();
         
@@ -123,6 +170,11 @@ public:
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
         
         glBindVertexArray(0);
+        
+        if(metrics) {
+            glEndQuery(GL_TIME_ELAPSED);
+            queries_issued[query_frame] = true;
+        }
     }
     
     void resize(unsigned int scr_width_u, unsigned int scr_height_u) {
@@ -137,6 +189,13 @@ public:
         createFramebuffer();
     }
     
+    // queue the readback of the frame drawn last, see Recorder
+    void record(Recorder& recorder) {
+        bind();
+        recorder.capture(width, height);
+        unbind();
+    }
+    
     void takeScreenshot(const std::string& name = "screenshot", bool show_image = false) {
         std::cout << "Taking screenshot: " << name << ".tga " << ", dimensions: " << width << ", " << height << std::endl;
         short TGA_header[] = {0, 2, 0, 0, 0, 0, width, height, 24};
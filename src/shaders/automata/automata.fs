@@ -6,9 +6,24 @@ in vec2 UV;
 #define COLOR_MAX 0.00392f // 1/255
 
 uniform usampler2D automata;
+uniform int states; // more than 2 for the Generations rules, the channel g then holds the state of the cell
+uniform sampler2D density; // the level of the density pyramid matching the zoom, the mean brightness of 2^level x 2^level cells per texel
+uniform int level; // 0 when zoomed in enough to draw the cells themselves
 
 void main() {
-    vec3 col = vec3(texture(automata, UV).rgb) * COLOR_MAX;
+    if(level > 0) {
+        fragColor = vec4(texture(density, UV).rgb, 1.0f);
+        return;
+    }
+    
+    uvec4 pixel = texture(automata, UV);
+    vec3 col = vec3(pixel.rgb) * COLOR_MAX;
+    
+    // the dying cells fade out with their state
+    if(states > 2) {
+        if(pixel.g >= 2u) col = mix(vec3(1.0f, 0.5f, 0.0f), vec3(0.1f, 0.0f, 0.3f), float(pixel.g - 2u) / float(max(states - 3, 1)));
+        else col = vec3(float(pixel.r) * COLOR_MAX);
+    }
+    
     fragColor = vec4(col, 1.0f);
 }
-
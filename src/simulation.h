@@ -0,0 +1,154 @@
+//
+//  simulation.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef simulation_h
+#define simulation_h
+
+// include the standard libraries
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "kernel.h"
+#include "metrics.h"
+
+#define SIMULATION_BATCH_TIME 0.01 // s, a batch of generations is sized to take about this long, so that a new generation is published at least this often
+#define SIMULATION_BATCH_MAX 4096 // generations of a batch at most
+
+// steps the kernel on a thread of its own, so that the generations per second are bound by the engine rather than by the frames of the window
+// at a fixed timestep a generation is due every iteration_length seconds: the time left over is carried to the next batch, the generations the engine cannot keep up with are dropped
+// in the turbo mode the batches follow one another as fast as the engine runs them
+// the newest generation is published to the renderer after every batch, see KernelGL::setDecoupled
+class Simulation {
+private:
+    KernelGL& kernel;
+    Metrics* metrics;
+    
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    float iteration_length;
+    bool running, turbo, paused, stepping, stopping;
+    
+    void run() {
+        double accumulator = 0.0; // the time not yet turned into generations
+        double generation_rate = 0.0; // the generations per second of the last batch
+        auto last_time = std::chrono::steady_clock::now();
+        
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true) {
+            if(!running || paused) {
+                condition.wait(lock, [this] { return (running && !paused) || stopping; });
+                accumulator = 0.0;
+                last_time = std::chrono::steady_clock::now();
+            }
+            if(stopping) return;
+            
+            auto time = std::chrono::steady_clock::now();
+            accumulator += std::chrono::duration<double>(time - last_time).count();
+            last_time = time;
+            
+            unsigned int batch_max = (unsigned int)std::max(1.0, std::min(generation_rate * SIMULATION_BATCH_TIME, (double)SIMULATION_BATCH_MAX));
+            unsigned int generations = batch_max;
+            
+            if(turbo) {
+                accumulator = 0.0;
+            } else {
+                if(accumulator < iteration_length) {
+                    // sleep until the next generation is due, a change of the settings wakes the thread earlier
+                    condition.wait_for(lock, std::chrono::duration<double>(iteration_length - accumulator));
+                    continue;
+                }
+                
+                double due = std::floor(accumulator / iteration_length);
+                accumulator -= due * iteration_length;
+                generations = (unsigned int)std::min(due, (double)batch_max);
+            }
+            
+            Metrics* batch_metrics = metrics;
+            stepping = true;
+            lock.unlock();
+            
+            auto batch_start = std::chrono::steady_clock::now();
+            kernel.step(generations);
+            kernel.publish();
+            double batch_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+            
+            generation_rate = generations / std::max(batch_time, 1e-6);
+            if(batch_metrics) batch_metrics->record("simulation_batch", batch_time);
+            
+            lock.lock();
+            stepping = false;
+            condition.notify_all();
+        }
+    }
+
+public:
+    // the kernel has to be decoupled and loaded before, the thread starts stepping it straight away
+    Simulation(KernelGL& kernel_u, float iteration_length_u) : kernel(kernel_u), metrics(nullptr), iteration_length(iteration_length_u), running(true), turbo(false), paused(false), stepping(false), stopping(false) {
+        thread = std::thread(&Simulation::run, this);
+    }
+    
+    ~Simulation() {
+        stop();
+    }
+    
+    // the batch in progress is finished first
+    void stop() {
+        if(!thread.joinable()) return;
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+    
+    // record the time of every batch to metrics, nullptr to stop
+    void setMetrics(Metrics* metrics_u) {
+        std::lock_guard<std::mutex> lock(mutex);
+        metrics = metrics_u;
+    }
+    
+    void setIterationLength(float iteration_length_u) {
+        std::lock_guard<std::mutex> lock(mutex);
+        iteration_length = iteration_length_u;
+        condition.notify_all();
+    }
+    
+    void setRunning(bool running_u) {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = running_u;
+        condition.notify_all();
+    }
+    
+    void setTurbo(bool turbo_u) {
+        std::lock_guard<std::mutex> lock(mutex);
+        turbo = turbo_u;
+        condition.notify_all();
+    }
+    
+    // wait for the batch in progress and keep the thread off the kernel until resume(), so that the board can be read
+    void pause() {
+        std::unique_lock<std::mutex> lock(mutex);
+        paused = true;
+        condition.wait(lock, [this] { return !stepping; });
+    }
+    
+    void resume() {
+        std::lock_guard<std::mutex> lock(mutex);
+        paused = false;
+        condition.notify_all();
+    }
+};
+
+#endif /* simulation_h */
@@ -0,0 +1,176 @@
+//
+//  thread_pool.h
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+#ifndef thread_pool_h
+#define thread_pool_h
+
+// include the standard libraries
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+// include the POSIX libraries
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// work-stealing thread pool: every worker has its own queue, takes its newest task first and steals the oldest ones from the others
+class ThreadPool {
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    size_t pending; // queued tasks, guarded by sleep_mutex
+    bool stopping;
+    
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    std::atomic<size_t> active; // queued and running tasks
+    
+    std::atomic<unsigned int> next_worker;
+    
+    // the worker index runs on the index-th CPU the process may use, so that the memory it touches first stays on the NUMA node of that CPU
+    // only on Linux, elsewhere the threads are left to the scheduler
+    static void pin(std::thread& thread, int index) {
+#ifdef __linux__
+        cpu_set_t allowed;
+        if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) return;
+        
+        int skipped = index % CPU_COUNT(&allowed);
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if(!CPU_ISSET(cpu, &allowed) || skipped-- > 0) continue;
+            
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+            return;
+        }
+#else
+        (void)thread;
+        (void)index;
+#endif
+    }
+    
+    static int& currentWorker() {
+        static thread_local int worker_index = -1;
+        return worker_index;
+    }
+    
+    bool popTask(int index, std::function<void()>& task) {
+        // own queue first (newest task, most likely still in cache), then steal the oldest task of the other workers
+        for(size_t i = 0; i < workers.size(); i++) {
+            Worker& worker = *workers[(index + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            
+            if(worker.tasks.empty()) continue;
+            
+            if(i == 0) {
+                task = std::move(worker.tasks.back());
+                worker.tasks.pop_back();
+            } else {
+                task = std::move(worker.tasks.front());
+                worker.tasks.pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+    
+    void run(int index) {
+        currentWorker() = index;
+        
+        while(true) {
+            {
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+                sleep_cv.wait(lock, [this] { return pending > 0 || stopping; });
+                if(stopping && pending == 0) return;
+            }
+            
+            std::function<void()> task;
+            if(!popTask(index, task)) continue;
+            
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                pending--;
+            }
+            
+            task();
+            
+            if(--active == 0) {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                done_cv.notify_all();
+            }
+        }
+    }
+
+public:
+    // pinned: every worker stays on a CPU of its own, for the callers that place their memory by first touch
+    ThreadPool(unsigned int threads_num, bool pinned = false) : pending(0), stopping(false), active(0), next_worker(0) {
+        if(threads_num == 0) threads_num = 1;
+        
+        for(unsigned int i = 0; i < threads_num; i++) workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        for(unsigned int i = 0; i < threads_num; i++) {
+            threads.push_back(std::thread(&ThreadPool::run, this, (int)i));
+            if(pinned) pin(threads.back(), (int)i);
+        }
+    }
+    
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        sleep_cv.notify_all();
+        
+        for(std::thread& thread : threads) thread.join();
+    }
+    
+    size_t size() const {
+        return workers.size();
+    }
+    
+    // queue a task on the given worker; by default on the calling worker, or round-robin when called from outside the pool
+    void submit(std::function<void()> task, int worker_index = -1) {
+        if(worker_index < 0) worker_index = currentWorker();
+        if(worker_index < 0) worker_index = (int)(next_worker++ % workers.size());
+        
+        active++;
+        {
+            Worker& worker = *workers[worker_index % workers.size()];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            pending++;
+        }
+        sleep_cv.notify_one();
+    }
+    
+    // block until all the queued tasks, and the tasks they queued, are done
+    void wait() {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cv.wait(lock, [this] { return active == 0; });
+    }
+};
+
+#endif /* thread_pool_h */
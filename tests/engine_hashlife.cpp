@@ -0,0 +1,136 @@
+//
+//  engine_hashlife.cpp
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+// a single huge step has to stay near the cap of the node cache, collecting in the middle of the step, and end in the same state as without the cap;
+// the generations stepped with a small cap, over several step sizes, have to match the cpu engine
+// usage: g++ -std=c++17 -O2 -pthread -Isrc tests/engine_hashlife.cpp -o engine_hashlife && ./engine_hashlife
+
+// include the standard libraries
+#include <vector>
+#include <iostream>
+
+#include "engine_cpu.h"
+#include "engine_hashlife.h"
+#include "ensemble.h"
+
+#define TEST_SIZE 128
+#define TEST_NODES_MAX (1 << 16)
+#define TEST_STEP_LOG 20
+#define TEST_GENERATIONS 1000
+
+// the runs of a board, emitted from the last row to the first, as the runs can come in any order
+class BoardRuns : public CellRuns {
+private:
+    const std::vector<unsigned char>& cells;
+    int width, height;
+
+public:
+    BoardRuns(const std::vector<unsigned char>& cells_u, int width_u, int height_u) : cells(cells_u), width(width_u), height(height_u) {}
+    
+    void forEachRun(const std::function<void(int, int, int)>& emit) {
+        for(int y = height - 1; y >= 0; y--) for(int x = 0; x < width;) {
+            int x_begin = x;
+            while(x < width && cells[(size_t)y * width + x]) x++;
+            if(x > x_begin) emit(x_begin, y, x - x_begin);
+            else x++;
+        }
+    }
+};
+
+// the alive cells as 1, the engines tell the newborn cells apart differently
+uint64_t aliveHash(Engine& engine) {
+    std::vector<unsigned char> cells((size_t)engine.width * engine.height);
+    engine.read(cells.data());
+    for(unsigned char& cell : cells) cell = cell ? 1 : 0;
+    return stateHash(cells.data(), engine.width, engine.height);
+}
+
+size_t readPopulation(Engine& engine) {
+    std::vector<unsigned char> cells((size_t)engine.width * engine.height);
+    engine.read(cells.data());
+    return statePopulation(cells.data(), engine.width, engine.height);
+}
+
+// the polynomial of quadtreeHash() summed over the cells read into bytes
+uint64_t readHash(Engine& engine) {
+    std::vector<unsigned char> cells((size_t)engine.width * engine.height);
+    engine.read(cells.data());
+    
+    uint64_t hash = 0, y_power = 1;
+    for(int y = 0; y < engine.height; y++) {
+        uint64_t power = y_power;
+        for(int x = 0; x < engine.width; x++) {
+            if(cells[(size_t)y * engine.width + x]) hash = (hash + power) % HASHLIFE_HASH_PRIME;
+            power = (uint64_t)((unsigned __int128)power * (HASHLIFE_HASH_X) % HASHLIFE_HASH_PRIME);
+        }
+        y_power = (uint64_t)((unsigned __int128)y_power * (HASHLIFE_HASH_Y) % HASHLIFE_HASH_PRIME);
+    }
+    return hash;
+}
+
+int main() {
+    std::vector<unsigned char> soup((size_t)TEST_SIZE * TEST_SIZE);
+    ensembleSoup(soup.data(), TEST_SIZE, TEST_SIZE, 3, 0.35f);
+    
+    int failures = 0;
+    
+    // 2^20 generations at once on the plane: the cache grows to hundreds of thousands of nodes without the collections in the middle of the step
+    EngineHashLife engine(true, TEST_NODES_MAX), engine_uncapped(true);
+    engine.load(soup.data(), TEST_SIZE, TEST_SIZE);
+    engine_uncapped.load(soup.data(), TEST_SIZE, TEST_SIZE);
+    engine.stepExponential(TEST_STEP_LOG);
+    engine_uncapped.stepExponential(TEST_STEP_LOG);
+    
+    if(engine.nodesPeak() > 2 * TEST_NODES_MAX) {
+        std::cerr << "FAILED: the cache of " << TEST_NODES_MAX << " nodes grew to " << engine.nodesPeak() << " nodes in a step of 2^" << TEST_STEP_LOG << " generations" << std::endl;
+        failures++;
+    }
+    if(engine.population() != engine_uncapped.population() || aliveHash(engine) != aliveHash(engine_uncapped)) {
+        std::cerr << "FAILED: the capped cache ends with " << engine.population() << " cells, the uncapped one with " << engine_uncapped.population() << std::endl;
+        failures++;
+    }
+    
+    // the headless mode reports the hash and the population of the quadtree instead of reading the board
+    if(engine.quadtreeHash() != readHash(engine) || engine.boardPopulation() != readPopulation(engine)) {
+        std::cerr << "FAILED: the quadtree hash or population differs from the one of the cells read" << std::endl;
+        failures++;
+    }
+    
+    // the runs go straight into the quadtree, on a torus that is not square the board is repeated along the shorter side
+    for(bool on_plane : {false, true}) {
+        BoardRuns runs(soup, TEST_SIZE, TEST_SIZE / 4);
+        EngineHashLife engine_runs(on_plane), engine_cells(on_plane);
+        engine_runs.loadRuns(runs, TEST_SIZE, TEST_SIZE / 4);
+        engine_cells.load(soup.data(), TEST_SIZE, TEST_SIZE / 4);
+        engine_runs.step(TEST_GENERATIONS);
+        engine_cells.step(TEST_GENERATIONS);
+        
+        if(aliveHash(engine_runs) != aliveHash(engine_cells)) {
+            std::cerr << "FAILED: " << engine_runs.name() << " loaded from the runs differs from the one loaded from the cells" << std::endl;
+            failures++;
+        }
+    }
+    
+    // the step sizes of 1000 = 512 + 256 + 128 + 64 + 32 + 8 in turn, twice, with the collections in between
+    EngineHashLife engine_torus(false, TEST_NODES_MAX / 4);
+    EngineCPU engine_cpu(1);
+    engine_torus.load(soup.data(), TEST_SIZE, TEST_SIZE);
+    engine_cpu.load(soup.data(), TEST_SIZE, TEST_SIZE);
+    for(int i = 0; i < 2; i++) {
+        engine_torus.step(TEST_GENERATIONS);
+        engine_cpu.step(TEST_GENERATIONS);
+        
+        if(aliveHash(engine_torus) != aliveHash(engine_cpu)) {
+            std::cerr << "FAILED: hashlife and cpu differ after " << engine_cpu.generation << " generations" << std::endl;
+            failures++;
+        }
+    }
+    
+    std::cout << (failures ? "FAILED" : "PASSED") << ": engine_hashlife, peak of the cache in a step of 2^" << TEST_STEP_LOG << " generations: " << engine.nodesPeak() << " nodes, uncapped: " << engine_uncapped.nodesPeak() << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,61 @@
+//
+//  engine_lenia.cpp
+//  Automata
+//
+//  Created by Antoni Wójcik on 18/10/2026.
+//  Copyright © 2026 Antoni Wójcik. All rights reserved.
+//
+
+// a soup of 0 and 1 cells, as the headless mode loads it, has to start with full states and keep its mass over the first generations
+// usage: g++ -std=c++17 -O2 -pthread -Isrc tests/engine_lenia.cpp -o engine_lenia && ./engine_lenia
+
+// include the standard libraries
+#include <vector>
+#include <iostream>
+
+#include "engine_lenia.h"
+#include "ensemble.h"
+
+#define TEST_SIZE 128
+#define TEST_GENERATIONS 5
+
+double mass(const EngineLenia& engine) {
+    std::vector<float> states((size_t)engine.width * engine.height);
+    engine.readStates(states.data());
+    
+    double sum = 0.0;
+    for(float state : states) sum += state;
+    return sum;
+}
+
+int main() {
+    std::vector<unsigned char> soup((size_t)TEST_SIZE * TEST_SIZE), soup_scaled(soup.size());
+    ensembleSoup(soup.data(), TEST_SIZE, TEST_SIZE, 1, 0.5f);
+    for(size_t i = 0; i < soup.size(); i++) soup_scaled[i] = soup[i] ? COLOR_MAX : 0;
+    
+    EngineLenia engine(1), engine_scaled(1);
+    engine.setRuleLenia(parseRuleLenia("R13,T10,M0.15,S0.015,B1"));
+    engine_scaled.setRuleLenia(engine.ruleLenia());
+    engine.load(soup.data(), TEST_SIZE, TEST_SIZE);
+    engine_scaled.load(soup_scaled.data(), TEST_SIZE, TEST_SIZE);
+    
+    int failures = 0;
+    if(mass(engine) != mass(engine_scaled)) {
+        std::cerr << "FAILED: the 0/1 soup starts with the mass " << mass(engine) << ", the 0/255 one with " << mass(engine_scaled) << std::endl;
+        failures++;
+    }
+    
+    engine.step(TEST_GENERATIONS);
+    engine_scaled.step(TEST_GENERATIONS);
+    if(mass(engine) <= 0.0) {
+        std::cerr << "FAILED: the mass of the 0/1 soup is 0 after " << TEST_GENERATIONS << " generations" << std::endl;
+        failures++;
+    }
+    if(mass(engine) != mass(engine_scaled)) {
+        std::cerr << "FAILED: the 0/1 and the 0/255 soups differ after " << TEST_GENERATIONS << " generations" << std::endl;
+        failures++;
+    }
+    
+    std::cout << (failures ? "FAILED" : "PASSED") << ": engine_lenia, mass after " << TEST_GENERATIONS << " generations: " << mass(engine) << std::endl;
+    return failures ? 1 : 0;
+}